@@ -0,0 +1,72 @@
+/**
+ * @author      : rbrugo (brugo.riccardo@gmail.com)
+ * @file        : tokenizer
+ * @created     : Sunday Oct 18, 2026 10:12:40 CEST
+ * @description : Throughput of `tokenized_line` and `parse_lines` on large record files
+ */
+
+#include "cliar.hpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+struct record_args
+{
+    cliar::option<std::string, "name of the job"> name;
+    cliar::option<int, "number of worker threads"> threads;
+    cliar::option<std::optional<bool>> verbose = false;
+    cliar::option<std::optional<std::string>, "-", "--output"> output;
+};
+
+auto generate_records(std::size_t size) -> std::string
+{
+    auto result = std::string{};
+    result.reserve(size + 128);
+    for (auto i = 0uz; result.size() < size; ++i) {
+        fmt::format_to(std::back_inserter(result),
+                       "--name \"job number {}\" --threads {} --verbose --output=/var/log/jobs/{:08}.log\n",
+                       i, i % 64, i);
+    }
+    return result;
+}
+
+auto read_file(char const * path) -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    auto stream = std::ostringstream{};
+    stream << file.rdbuf();
+    return std::move(stream).str();
+}
+
+template <typename Fn>
+auto measure(std::string_view label, std::size_t bytes, Fn && fn) -> void
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const count = fn();
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    fmt::print("{:<12} {:>10} items in {:.3f}s: {:.3f} GB/s\n",
+               label, count, elapsed.count(), static_cast<double>(bytes) / elapsed.count() / 1e9);
+}
+
+int main(int argc, char * argv[])
+{
+    // Usage: cliar_benchmarks [record file]; without a file, 256 MB of records are generated
+    auto const text = argc > 1 ? read_file(argv[1]) : generate_records(256'000'000);
+    fmt::print("{} MB of records\n", text.size() / 1'000'000);
+
+    measure("tokenize", text.size(), [&text] {
+        auto tokens = 0uz;
+        for (auto && line : text | std::views::split('\n')) {
+            tokens += cliar::tokenized_line{std::string_view{line.begin(), line.end()}}.args().size();
+        }
+        return tokens;
+    });
+
+    measure("parse_lines", text.size(), [&text] {
+        auto records = 0uz;
+        for (auto const & record : cliar::parse_lines<record_args>(text)) {
+            records += record.threads >= 0;
+        }
+        return records;
+    });
+}
@@ -0,0 +1,40 @@
+# Writes the JSON schema of a cliar `Cli` aggregate at build time, so that external tools (e.g. a
+# job scheduler) can validate command lines without spawning the program.
+#
+#   cliar_add_schema(<target>
+#       HEADER <header declaring the Cli aggregate>
+#       TYPE <fully qualified name of the Cli aggregate>
+#       [OUTPUT <json file>]   # defaults to ${CMAKE_CURRENT_BINARY_DIR}/<target>.json
+#   )
+#
+# The schema is produced by a small generator executable calling `cliar::schema<TYPE>()`.
+
+include_guard()
+
+set(CLIAR_SCHEMA_TEMPLATE "${CMAKE_CURRENT_LIST_DIR}/cliar_schema.cpp.in")
+
+function(cliar_add_schema target)
+  cmake_parse_arguments(PARSE_ARGV 1 ARG "" "HEADER;TYPE;OUTPUT" "")
+  if(NOT ARG_HEADER OR NOT ARG_TYPE)
+    message(FATAL_ERROR "cliar_add_schema(${target}): HEADER and TYPE are required")
+  endif()
+  if(NOT ARG_OUTPUT)
+    set(ARG_OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/${target}.json")
+  endif()
+
+  get_filename_component(CLIAR_SCHEMA_HEADER "${ARG_HEADER}" ABSOLUTE)
+  set(CLIAR_SCHEMA_TYPE "${ARG_TYPE}")
+  set(generator_source "${CMAKE_CURRENT_BINARY_DIR}/${target}_generator.cpp")
+  configure_file("${CLIAR_SCHEMA_TEMPLATE}" "${generator_source}" @ONLY)
+
+  add_executable(${target}_generator "${generator_source}")
+  target_link_libraries(${target}_generator PRIVATE cliar)
+
+  add_custom_command(
+    OUTPUT "${ARG_OUTPUT}"
+    COMMAND ${target}_generator "${ARG_OUTPUT}"
+    DEPENDS ${target}_generator
+    COMMENT "Generating cliar schema ${ARG_OUTPUT}"
+    VERBATIM)
+  add_custom_target(${target} ALL DEPENDS "${ARG_OUTPUT}")
+endfunction()
@@ -10,20 +10,124 @@
 
 #include "reflect"
 #include <type_traits>
+#include <algorithm>
 #include <string>
 #include <vector>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <span>
+#include <memory>
+#include <istream>
+#include <functional>
+#include <utility>
 #include <fmt/ranges.h>
 #include <ranges>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace cliar
 {
 
+/**
+ * @brief A string with a fixed capacity, stored inline
+ *
+ * Use `option<inplace_string<N>>` instead of `option<std::string>` to parse string options without
+ * allocating memory. Values longer than `N` characters are rejected by `parse`.
+ *
+ * @tparam N the maximum number of characters
+ */
+template <std::size_t N>
+class inplace_string
+{
+public:
+    constexpr inplace_string() = default;
+
+    constexpr inplace_string(std::string_view str)
+    {
+        if (str.size() > N) {
+            throw std::length_error("string exceeds the capacity of inplace_string");
+        }
+        std::ranges::copy(str, _data.begin());
+        _size = str.size();
+    }
+
+    constexpr inplace_string(char const * str) : inplace_string(std::string_view{str}) {}
+
+    [[nodiscard]] static constexpr auto capacity() noexcept -> std::size_t { return N; }
+    [[nodiscard]] constexpr auto size() const noexcept -> std::size_t { return _size; }
+    [[nodiscard]] constexpr auto empty() const noexcept -> bool { return _size == 0; }
+    [[nodiscard]] constexpr auto data() const noexcept -> char const * { return _data.data(); }
+
+    [[nodiscard]]
+    explicit(false) constexpr operator std::string_view() const noexcept { return {_data.data(), _size}; }
+
+    friend constexpr bool operator==(inplace_string const & lhs, std::string_view rhs) noexcept
+    {
+        return std::string_view{lhs} == rhs;
+    }
+
+private:
+    std::array<char, N> _data{};
+    std::size_t _size = 0;
+};
+
 namespace refl {
 template <typename>
 constexpr inline auto is_optional = false;
 template <template <typename> class C, class T>
 constexpr inline auto is_optional<C<T>> = std::same_as<C<T>, std::optional<T>>;
 
+template <typename>
+constexpr inline auto is_inplace_string = false;
+template <std::size_t N>
+constexpr inline auto is_inplace_string<inplace_string<N>> = true;
+
+/**
+ * @brief Converts a number to a `fixed_string`
+ */
+template <std::size_t N>
+consteval auto to_fixed_string()
+{
+    constexpr auto digits = [] {
+        auto count = std::size_t{1};
+        for (auto n = N; n >= 10; n /= 10) {
+            ++count;
+        }
+        return count;
+    }();
+    char data[digits + 1]{};
+    auto n = N;
+    for (auto i = digits; i > 0; --i) {
+        data[i - 1] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    }
+    return reflect::fixed_string{data};
+}
+
+template <typename>
+constexpr inline auto is_fixed_arity = false;
+template <typename T, std::size_t N>
+constexpr inline auto is_fixed_arity<std::array<T, N>> = N > 0;
+template <typename ...Ts>
+constexpr inline auto is_fixed_arity<std::tuple<Ts...>> = sizeof...(Ts) > 0;
+
+template <typename T>
+struct unwrap_optional { using type = T; };
+template <typename T>
+struct unwrap_optional<std::optional<T>> { using type = T; };
+template <typename T>
+using unwrap_optional_t = typename unwrap_optional<T>::type;
+
+template <typename T>
+constexpr inline auto is_flag = std::same_as<T, bool> or std::same_as<T, std::optional<bool>>;
+
 template <typename Aggregate, auto I>
 using member_type = std::remove_cvref_t<decltype(reflect::get<I>(std::declval<Aggregate>()))>;
 
@@ -95,6 +199,9 @@ consteval auto to_kebab_case(reflect::fixed_string<C, N> s)
     return s;
 }
 
+template <typename T, std::size_t I = 0>
+consteval auto tuple_type_name();
+
 /**
  * @brief Generates a name for a given type
  *
@@ -127,6 +234,12 @@ consteval auto type_name() noexcept
     else if constexpr (std::same_as<type, std::string>) {
         return reflect::fixed_string{"string"};
     }
+    else if constexpr (is_inplace_string<type>) {
+        return refl::concat(refl::concat("string[", to_fixed_string<type::capacity()>()), "]");
+    }
+    else if constexpr (is_fixed_arity<type>) {
+        return tuple_type_name<type>();
+    }
     else if constexpr (refl::is_optional<type> and not refl::is_optional<typename type::value_type>) {
         return refl::concat(refl::concat("optional<", type_name<typename type::value_type>()), ">");
     } else {
@@ -134,15 +247,32 @@ consteval auto type_name() noexcept
     }
 }
 
+/**
+ * @brief Generates the name of a `std::array` or `std::tuple` as the names of its elements,
+ * separated by spaces (e.g. `int int int`)
+ */
+template <typename T, std::size_t I>
+consteval auto tuple_type_name()
+{
+    constexpr auto head = type_name<std::tuple_element_t<I, T>>();
+    if constexpr (I + 1 == std::tuple_size_v<T>) {
+        return head;
+    } else {
+        return refl::concat(refl::concat(head, " "), tuple_type_name<T, I + 1>());
+    }
+}
+
 template <typename T, std::size_t I>
     requires std::is_aggregate_v<std::remove_cvref_t<T>>
 consteval auto has_default_value()
 {
     auto test = T{};
     auto const & member = reflect::get<I>(test);
-    using value_type = typename std::remove_cvref_t<decltype(member)>::value_type;
+    using member_t = std::remove_cvref_t<decltype(member)>;
 
-    if constexpr (is_optional<value_type>) {
+    if constexpr (not requires { typename member_t::value_type; }) {
+        return false;
+    } else if constexpr (is_optional<typename member_t::value_type>) {
         return member.has_value();
     } else {
         return false;
@@ -156,6 +286,23 @@ consteval auto get_default_value()
     return std::move(*reflect::get<I>(Cli{}));
 }
 
+/**
+ * @brief Finds the index of a member given its name
+ *
+ * @tparam Aggregate the aggregate containing the member
+ * @tparam Name the name of the member
+ * @return the index of the member named `Name`
+ */
+template <typename Aggregate, reflect::fixed_string Name>
+    requires reflect::has_member_name<Aggregate, Name>
+consteval auto member_index() -> std::size_t
+{
+    constexpr auto names = []<std::size_t ...I>(std::index_sequence<I...>) {
+        return std::array<std::string_view, sizeof...(I)>{reflect::member_name<I, Aggregate>()...};
+    }(std::make_index_sequence<reflect::size<Aggregate>()>());
+    return static_cast<std::size_t>(std::ranges::find(names, std::string_view{Name}) - names.begin());
+}
+
 template <typename Cli>
 consteval auto to_tuple_of_optionals_impl()
 {
@@ -185,11 +332,26 @@ consteval bool short_name_disabled() { return ((is_short_name<Str>() and std::st
 
 
 template <typename T>
-concept valid_option_primitive = std::same_as<T, bool>
+concept valid_option_scalar = std::same_as<T, bool>
                          or std::signed_integral<T>
                          or std::unsigned_integral<T>
                          or std::floating_point<T>
-                         or std::same_as<T, std::string>;
+                         or std::same_as<T, std::string>
+                         or refl::is_inplace_string<T>;
+
+namespace detail {
+template <typename T>
+consteval bool elements_are_scalars()
+{
+    return []<std::size_t ...I>(std::index_sequence<I...>) {
+        return (valid_option_scalar<std::tuple_element_t<I, T>> and ...);
+    }(std::make_index_sequence<std::tuple_size_v<T>>());
+}
+}  // namespace detail
+
+template <typename T>
+concept valid_option_primitive = valid_option_scalar<T>
+                              or (refl::is_fixed_arity<T> and detail::elements_are_scalars<T>());
 
 template <typename T>
 concept valid_option_optional = refl::is_optional<T>
@@ -204,7 +366,10 @@ concept valid_option_type = valid_option_optional<T> or valid_option_primitive<T
  * @brief A class representing a CLI argument for the program
  *
  * The first template argument is the option type. It must be either an integer, a floating point
- * number, a string, a bool or an optional of one of the previous type.
+ * number, a string, a bool, a `std::array` or `std::tuple` of those, or an optional of one of the
+ * previous type. Arrays and tuples are passed either as separate arguments (`--tile 256 256 4`) or
+ * as a single value separated by `,` or `:` (`--range=10:20`, or `--range 10:20` if all the
+ * elements are numbers).
  * Every template argument after the first one must be a string literal, and will be used to
  * determinate the short and the long name for the option, and eventually a description.
  * The rules regarding those literals are:
@@ -341,6 +506,29 @@ constexpr inline auto is_option = false;
 template <template <typename, auto...> class C, class T, auto ...Args>
 constexpr inline auto is_option<C<T, Args...>> = std::same_as<C<T, Args...>, option<T, Args...>>;
 
+namespace detail {
+template <typename Flags>
+consteval auto members_are_flags()
+{
+    return []<std::size_t ...I>(std::index_sequence<I...>) {
+        return ((is_option<refl::member_type<Flags, I>>
+                 and refl::is_flag<typename refl::member_type<Flags, I>::value_type>) and ...);
+    }(std::make_index_sequence<reflect::size<Flags>()>());
+}
+}  // namespace detail
+
+template <typename Flags>
+concept valid_flag_group = std::is_aggregate_v<Flags> and detail::members_are_flags<Flags>();
+
+template <typename Flags>
+    requires valid_flag_group<Flags>
+class flag_set;
+
+template <typename>
+constexpr inline auto is_flag_set = false;
+template <typename Flags>
+constexpr inline auto is_flag_set<flag_set<Flags>> = true;
+
 template <typename T, reflect::fixed_string ...Args>
 struct format_arg
 {
@@ -429,7 +617,7 @@ template <typename Cli>
 consteval auto members_are_cli_args_impl()
 {
     return []<std::size_t ...I>(std::index_sequence<I...>) {
-        return (is_option<cliar::refl::member_type<Cli, I>> and ...);
+        return ((is_option<cliar::refl::member_type<Cli, I>> or is_flag_set<cliar::refl::member_type<Cli, I>>) and ...);
     }(std::make_index_sequence<reflect::size<Cli>()>());
 }
 }  // namespace detail
@@ -457,33 +645,50 @@ class repeated_option : public std::invalid_argument
     using std::invalid_argument::invalid_argument;
 };
 
+class conflicting_options : public std::invalid_argument
+{
+    using std::invalid_argument::invalid_argument;
+};
+
+class malformed_command_line : public std::invalid_argument
+{
+    using std::invalid_argument::invalid_argument;
+};
+
+class invalid_snapshot : public std::invalid_argument
+{
+    using std::invalid_argument::invalid_argument;
+};
+
 
 // Functions
 /**
- * @brief Check wether the Cli template argument contains duplicate option names
+ * @brief Lists every enabled option name of the Cli template argument
  *
- * @tparam Cli The aggregate type to check
- * @return `true` if any duplicate is found, `false` otherwise
+ * @tparam Cli The aggregate type to inspect
+ * @return the option names of `Cli`
  */
 template <typename Cli>
-consteval auto has_repeated_option_names()
+constexpr auto enabled_option_names()
 {
-    auto names = std::vector<std::string>{};
-
     constexpr auto size = reflect::size<Cli>();
     auto fn = []<auto N>(this auto const & self, refl::consteval_value<N>) {
         using member_type = refl::member_type<Cli, N>;
         constexpr auto I = std::integral_constant<std::size_t, N>{};
         auto ns = std::vector<std::string>{};
-        if constexpr (not member_type::long_name_disabled) {
-            ns.push_back(static_cast<std::string>(static_cast<std::string_view>(
-                cliar::long_name_unconditional<Cli, I>()
-            )));
-        }
-        if constexpr (not member_type::short_name_disabled) {
-            ns.push_back(static_cast<std::string>(static_cast<std::string_view>(
-                cliar::short_name_unconditional<Cli, I>()
-            )));
+        if constexpr (is_flag_set<member_type>) {
+            ns = enabled_option_names<typename member_type::flags_type>();
+        } else {
+            if constexpr (not member_type::long_name_disabled) {
+                ns.push_back(static_cast<std::string>(static_cast<std::string_view>(
+                    cliar::long_name_unconditional<Cli, I>()
+                )));
+            }
+            if constexpr (not member_type::short_name_disabled) {
+                ns.push_back(static_cast<std::string>(static_cast<std::string_view>(
+                    cliar::short_name_unconditional<Cli, I>()
+                )));
+            }
         }
         if constexpr (N + 1 < size) {
             auto next = self(refl::consteval_value<N + 1>{});
@@ -494,19 +699,37 @@ consteval auto has_repeated_option_names()
         }
         return ns;
     };
-    // };
-    auto result = fn(refl::consteval_value<0>{});
+    return fn(refl::consteval_value<0>{});
+}
+
+/**
+ * @brief Check wether the Cli template arguments contain duplicate option names
+ *
+ * Names are compared across all the types, so that they can be parsed from the same arguments.
+ *
+ * @tparam Clis The aggregate types to check
+ * @return `true` if any duplicate is found, `false` otherwise
+ */
+template <typename ...Clis>
+consteval auto has_repeated_option_names()
+{
+    auto result = std::vector<std::string>{};
+    ([&result] {
+        for (auto & name : enabled_option_names<Clis>()) {
+            result.push_back(std::move(name));
+        }
+    }(), ...);
     std::sort(result.begin(), result.end());
 
     return std::ranges::adjacent_find(result) != result.end();
 }
 
 
-template <typename Cli>
+template <typename ...Clis>
 consteval void check_repeated_names()
 {
     static_assert(
-        not has_repeated_option_names<Cli>(), "\n"
+        (not has_repeated_option_names<Clis>() and ...), "\n"
         " ############################################################################################\n"
         " #                 The Cli class must not contain repeated option names!                    #\n"
         " #       Remember that unspecified short and option names are deduced as follow:            #\n"
@@ -517,7 +740,219 @@ consteval void check_repeated_names()
       R"( #                   passing "-" / "--" as non-type template parameters.                    #)""\n"
         " ############################################################################################"
     );
+    static_assert(
+        (has_repeated_option_names<Clis>() or ...) or not has_repeated_option_names<Clis...>(), "\n"
+        " ############################################################################################\n"
+        " #                 Cli classes parsed together must not share option names!                 #\n"
+        " #    An option name of one class clashes with an option name of another one: rename one    #\n"
+      R"( #        of them, or disable it passing "-" / "--" as non-type template parameters.        #)""\n"
+        " ############################################################################################"
+    );
+}
+
+// Constraints
+enum class constraint_kind
+{
+    at_most_one_of,
+    exactly_one_of,
+    at_least_one_of,
+    requires_all,
+};
+
+/**
+ * @brief A relationship between options of a `Cli`, identified by their member names
+ *
+ * Constraints are listed in a `constraints` type alias inside the `Cli` aggregate, are compiled
+ * into bitmasks over the member indices and are checked by `parse` against the options that
+ * were actually passed on the command line (defaults don't count). Example:
+ * ```cpp
+ * struct cli_args
+ * {
+ *     using constraints = std::tuple<
+ *         cliar::at_most_one_of<"only_long", "set_both">,  // conflicting options
+ *         cliar::exactly_one_of<"tcp", "udp", "unix">,
+ *         cliar::requires_all<"user", "password">          // `--user` needs `--password`
+ *     >;
+ *     ...
+ * };
+ * ```
+ *
+ * @tparam Kind the kind of relationship
+ * @tparam Members the names of the members involved; for `requires_all`, the first one
+ *                 requires all the others
+ */
+template <constraint_kind Kind, reflect::fixed_string ...Members>
+struct constraint
+{
+    static_assert(sizeof...(Members) >= 2, "A constraint must involve at least two options");
+
+    static constexpr auto kind = Kind;
+
+    template <typename Cli>
+    static consteval auto indices()
+    {
+        return std::array<std::size_t, sizeof...(Members)>{refl::member_index<Cli, Members>()...};
+    }
+};
+
+template <reflect::fixed_string ...Members>
+using at_most_one_of = constraint<constraint_kind::at_most_one_of, Members...>;
+template <reflect::fixed_string ...Members>
+using exactly_one_of = constraint<constraint_kind::exactly_one_of, Members...>;
+template <reflect::fixed_string ...Members>
+using at_least_one_of = constraint<constraint_kind::at_least_one_of, Members...>;
+template <reflect::fixed_string ...Members>
+using requires_all = constraint<constraint_kind::requires_all, Members...>;
+
+namespace detail {
+/**
+ * @brief The name used to refer to the `I`-th member in messages: the long name if enabled,
+ * the short name otherwise, the member name for a `flag_set`
+ */
+template <typename Cli, std::size_t I>
+consteval auto display_name() -> std::string_view
+{
+    constexpr auto N = std::integral_constant<std::size_t, I>{};
+    if constexpr (is_flag_set<refl::member_type<Cli, I>>) {
+        return reflect::member_name<I, Cli>();
+    } else if constexpr (constexpr auto long_name = cliar::long_name<Cli, N>(); long_name.has_value()) {
+        return *long_name;
+    } else {
+        return *cliar::short_name<Cli, N>();
+    }
+}
+
+template <typename Cli>
+constexpr inline auto display_names = []<std::size_t ...I>(std::index_sequence<I...>) {
+    return std::array<std::string_view, sizeof...(I)>{display_name<Cli, I>()...};
+}(std::make_index_sequence<reflect::size<Cli>()>());
+
+template <std::size_t N>
+struct constraint_mask
+{
+    constraint_kind kind;
+    std::bitset<N> trigger;
+    std::bitset<N> members;
+};
+
+template <typename Cli, typename Constraint>
+consteval auto make_constraint_mask()
+{
+    auto result = constraint_mask<reflect::size<Cli>()>{Constraint::kind, {}, {}};
+    constexpr auto indices = Constraint::template indices<Cli>();
+    for (auto idx : indices) {
+        result.members.set(idx);
+    }
+    if constexpr (Constraint::kind == constraint_kind::requires_all) {
+        result.members.reset(indices.front());
+        result.trigger.set(indices.front());
+    }
+    return result;
+}
+
+template <typename Cli>
+consteval auto constraints_of()
+{
+    if constexpr (requires { typename Cli::constraints; }) {
+        return std::type_identity<typename Cli::constraints>{};
+    } else {
+        return std::type_identity<std::tuple<>>{};
+    }
+}
+
+template <typename Cli>
+constexpr inline auto constraint_masks = []<typename ...C>(std::type_identity<std::tuple<C...>>) {
+    return std::array<constraint_mask<reflect::size<Cli>()>, sizeof...(C)>{make_constraint_mask<Cli, C>()...};
+}(constraints_of<Cli>());
+
+template <typename Cli>
+auto names_in_mask(std::bitset<reflect::size<Cli>()> const & mask) -> std::vector<std::string_view>
+{
+    auto result = std::vector<std::string_view>{};
+    for (auto i = std::size_t{0}; i < mask.size(); ++i) {
+        if (mask[i]) {
+            result.push_back(display_names<Cli>[i]);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Checks the constraints of `Cli` against the set of options passed on the command line
+ *
+ * @param seen the indices of the members found on the command line
+ * @throw conflicting_options if too many options of a group are passed
+ * @throw missing_required_option if a group or a `requires_all` is not satisfied
+ */
+template <typename Cli>
+auto check_constraints(std::bitset<reflect::size<Cli>()> const & seen) -> void
+{
+    for (auto const & [kind, trigger, members] : constraint_masks<Cli>) {
+        auto const given = seen & members;
+        auto const count = given.count();
+        switch (kind) {
+        case constraint_kind::at_most_one_of:
+        case constraint_kind::exactly_one_of:
+            if (count > 1) {
+                throw conflicting_options(fmt::format(
+                    "Options {} can't be used together", fmt::join(names_in_mask<Cli>(given), ", ")
+                ));
+            }
+            if (kind == constraint_kind::exactly_one_of and count == 0) {
+                throw missing_required_option(fmt::format(
+                    "Exactly one of {} is required", fmt::join(names_in_mask<Cli>(members), ", ")
+                ));
+            }
+            break;
+        case constraint_kind::at_least_one_of:
+            if (count == 0) {
+                throw missing_required_option(fmt::format(
+                    "At least one of {} is required", fmt::join(names_in_mask<Cli>(members), ", ")
+                ));
+            }
+            break;
+        case constraint_kind::requires_all:
+            if ((seen & trigger).any() and given != members) {
+                throw missing_required_option(fmt::format(
+                    "Option {} requires {}",
+                    fmt::join(names_in_mask<Cli>(trigger), ""),
+                    fmt::join(names_in_mask<Cli>(members & ~seen), ", ")
+                ));
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Describes the constraints of `Cli`, one per line, for `help`
+ */
+template <typename Cli>
+auto describe_constraints() -> std::vector<std::string>
+{
+    auto result = std::vector<std::string>{};
+    for (auto const & [kind, trigger, members] : constraint_masks<Cli>) {
+        auto const names = names_in_mask<Cli>(members);
+        switch (kind) {
+        case constraint_kind::at_most_one_of:
+            result.push_back(fmt::format("    at most one of {}", fmt::join(names, ", ")));
+            break;
+        case constraint_kind::exactly_one_of:
+            result.push_back(fmt::format("    exactly one of {}", fmt::join(names, ", ")));
+            break;
+        case constraint_kind::at_least_one_of:
+            result.push_back(fmt::format("    at least one of {}", fmt::join(names, ", ")));
+            break;
+        case constraint_kind::requires_all:
+            result.push_back(fmt::format(
+                "    {} requires {}", fmt::join(names_in_mask<Cli>(trigger), ""), fmt::join(names, ", ")
+            ));
+            break;
+        }
+    }
+    return result;
 }
+}  // namespace detail
 
 // Functions
 /**
@@ -536,11 +971,11 @@ auto help(std::string_view program_name, std::string_view additional_comment)
     check_repeated_names<Cli>();
     auto flags = std::vector<std::string>{};
     auto options = std::vector<std::string>{};
-    reflect::for_each<Cli>([&flags, &options](auto I) {
-        using member_type = refl::member_type<Cli, I>;
+    auto describe = [&flags, &options]<typename Aggregate>(std::type_identity<Aggregate>, auto I) {
+        using member_type = refl::member_type<Aggregate, I>;
         using value_t = member_type::value_type;
-        constexpr auto long_name = cliar::long_name<Cli, I>();
-        constexpr auto short_name = cliar::short_name<Cli, I>();
+        constexpr auto long_name = cliar::long_name<Aggregate, I>();
+        constexpr auto short_name = cliar::short_name<Aggregate, I>();
         constexpr auto description = member_type::description();
         constexpr auto has_short = short_name.has_value();
         constexpr auto has_long = long_name.has_value();
@@ -549,9 +984,9 @@ auto help(std::string_view program_name, std::string_view additional_comment)
         constexpr auto second = std::string_view{(has_short and has_long) ? *long_name : ""};
 
         auto default_value = [I] {
-            if constexpr (refl::has_default_value<Cli, I>()) {
+            if constexpr (refl::has_default_value<Aggregate, I>()) {
                 try {
-                    return fmt::format(" (default: {})", refl::get_default_value<Cli, I>());
+                    return fmt::format(" (default: {})", refl::get_default_value<Aggregate, I>());
                 } catch (...) {
                     return std::string{};
                 }
@@ -560,7 +995,7 @@ auto help(std::string_view program_name, std::string_view additional_comment)
             }
         }();
 
-        if constexpr (std::same_as<value_t, bool> or std::same_as<value_t, std::optional<bool>>) {
+        if constexpr (refl::is_flag<value_t>) {
             auto names = fmt::format("{}{}{}", first, separator, second);
             flags.push_back(fmt::format("    {:<50}{}{}", names, std::string_view{description}, default_value));
         } else {
@@ -568,6 +1003,15 @@ auto help(std::string_view program_name, std::string_view additional_comment)
             auto with_type = fmt::format("{:<25} {}", names, refl::type_name<value_t>());
             options.push_back(fmt::format("    {:<50}{}{}", with_type, std::string_view{description}, default_value));
         }
+    };
+    reflect::for_each<Cli>([&describe](auto I) {
+        using member_type = refl::member_type<Cli, I>;
+        if constexpr (is_flag_set<member_type>) {
+            using flags_t = member_type::flags_type;
+            reflect::for_each<flags_t>([&describe](auto J) { describe(std::type_identity<flags_t>{}, J); });
+        } else {
+            describe(std::type_identity<Cli>{}, I);
+        }
     });
     constexpr auto nothing = std::string_view{};
     auto flags_tag = flags.empty() ? std::string_view{"[flags] "} : nothing;
@@ -576,15 +1020,20 @@ auto help(std::string_view program_name, std::string_view additional_comment)
     auto flags_marker = flags.empty() ? nothing : std::string_view{"\n\nFLAGS:\n"};
     auto options_marker = options.empty() ? nothing : std::string_view{"\n\nOPTIONS:\n"};
 
+    auto const constraints = detail::describe_constraints<Cli>();
+    auto constraints_marker = constraints.empty() ? nothing : std::string_view{"\n\nCONSTRAINTS:\n"};
+
     auto comment_newline = additional_comment.empty() ? std::string_view{} : std::string_view{"\n\n"};
 
-    return fmt::format("Usage: {} {} {}{}{}{}{}{}{}\n",
+    return fmt::format("Usage: {} {} {}{}{}{}{}{}{}{}{}\n",
                        program_name,
                        flags_tag, options_tag,
                        flags_marker,
                        fmt::join(flags, "\n"),
                        options_marker,
                        fmt::join(options, "\n"),
+                       constraints_marker,
+                       fmt::join(constraints, "\n"),
                        comment_newline,
                        additional_comment
                        );
@@ -612,129 +1061,515 @@ auto parse_arg(std::string_view rng) -> std::optional<T>
         return std::nullopt;
     } else if constexpr (std::is_same_v<T, std::string>) {
         return rng | std::ranges::to<std::string>();
+    } else if constexpr (refl::is_inplace_string<T>) {
+        if (rng.size() > T::capacity()) {
+            return std::nullopt;
+        }
+        return T{rng};
+    } else if constexpr (refl::is_fixed_arity<T>) {
+        constexpr auto delimiters = std::string_view{",:"};
+        auto result = T{};
+        auto rest = rng;
+        auto const ok = [&result, &rest, delimiters]<std::size_t ...I>(std::index_sequence<I...>) {
+            return ([&result, &rest, delimiters] {
+                constexpr auto is_last = I + 1 == sizeof...(I);
+                auto const idx = rest.find_first_of(delimiters);
+                if (is_last == (idx != std::string_view::npos)) {
+                    return false;
+                }
+                auto element = parse_arg<std::tuple_element_t<I, T>>(rest.substr(0, idx));
+                if (not element.has_value()) {
+                    return false;
+                }
+                std::get<I>(result) = std::move(*element);
+                rest = is_last ? std::string_view{} : rest.substr(idx + 1);
+                return true;
+            }() and ...);
+        }(std::make_index_sequence<std::tuple_size_v<T>>());
+        if (not ok) {
+            return std::nullopt;
+        }
+        return result;
     } else if constexpr (refl::is_optional<T>) {
         return parse_arg<typename T::value_type>(rng);
     } else {
-        static_assert(false, "You can only convert numbers, booleans and strings");
+        static_assert(false, "You can only convert numbers, booleans, strings, arrays and tuples");
     }
 }
 
 
-template <typename T, typename It>
-auto parse_option(It it, auto short_name, auto long_name) -> std::pair<It, T>
+/**
+ * @brief Parses the value of the option found at position `pos`
+ *
+ * The value is either the part following `=` in the same token, or the next token.
+ * Arrays and tuples of `N` elements may also consume the `N` following tokens; when all their
+ * elements are numbers, a next token containing a `,` or `:` delimiter is instead the whole value.
+ *
+ * @tparam T the type of the option
+ * @param cli_args the command line arguments
+ * @param pos the position of the option in `cli_args`
+ * @return the position of the last consumed token and the parsed value
+ */
+template <typename T, typename Arg>
+auto parse_option(std::span<Arg const> const cli_args, std::size_t pos) -> std::pair<std::size_t, T>
 {
-    auto parse_value = [short_name, long_name, &it](auto match) -> std::string_view {
-        auto same = [](std::string_view a, std::string_view b) {
-            return a == b;
-        };
-
-        if (same(match, short_name) or same(match, long_name)) {
-            ++it;
-            auto res = std::string_view{*it};
-            constexpr auto is_arithmetic = [] {
-                if constexpr (std::is_arithmetic_v<T>) {
-                    return true;
-                } else if constexpr (not refl::is_optional<T>) {
-                    return false;
-                } else {
-                    return std::is_arithmetic_v<typename T::value_type>;
-                }
-            }();
-            if constexpr (is_arithmetic) {
-                if (res.starts_with("--")) {
-                    throw wrong_option_type(fmt::format(
-                        "Expected argument of type {}, got option '{}'", refl::type_name<T>(), res
-                    ));
-                }
+    using primitive_t = refl::unwrap_optional_t<T>;
+    auto const option = std::string_view{cli_args[pos]};
+    auto next_value = [cli_args, option, &pos]<typename U>(std::type_identity<U>) -> std::string_view {
+        ++pos;
+        if (pos == cli_args.size()) {
+            throw wrong_option_type(fmt::format(
+                "Option {} expects an argument of type {}", option, refl::type_name<U>()
+            ));
+        }
+        auto res = std::string_view{cli_args[pos]};
+        using value_t = refl::unwrap_optional_t<U>;
+        constexpr auto is_numeric = [] {
+            if constexpr (refl::is_fixed_arity<value_t>) {
+                return std::is_arithmetic_v<std::tuple_element_t<0, value_t>>;
             } else {
-                if (res.starts_with("-")) {
-                    throw wrong_option_type(fmt::format(
-                        "Expected argument of type {}, got option '{}'", refl::type_name<T>(), res
-                    ));
-                }
-            }
-            return res;
-        } else {
-            auto split = std::views::split(std::string_view{*it}, std::string_view{"="})
-                | std::ranges::to<std::vector<std::string>>();
-            auto str = std::string_view{*it};
-            auto idx = str.find('=');
-            if (idx == std::string_view::npos) {
-                throw unknown_option(fmt::format(
-                    "Unknown option '{}' (maybe you meant {} {}?)", str, short_name, long_name
-                ));
+                return std::is_arithmetic_v<value_t>;
             }
-            return str.substr(idx + 1);
+        }();
+        auto const is_option = is_numeric ? res.starts_with("--") : res.starts_with("-");
+        if (is_option) {
+            throw wrong_option_type(fmt::format(
+                "Expected argument of type {}, got option '{}'", refl::type_name<U>(), res
+            ));
         }
+        return res;
     };
 
-    auto _value = parse_value(*it);
+    if constexpr (refl::is_fixed_arity<primitive_t>) {
+        // Strings may contain delimiters themselves, e.g. `--hosts http://a http://b`
+        constexpr auto all_numeric = []<std::size_t ...I>(std::index_sequence<I...>) {
+            return (std::is_arithmetic_v<std::tuple_element_t<I, primitive_t>> and ...);
+        }(std::make_index_sequence<std::tuple_size_v<primitive_t>>());
+        auto const is_delimited = option.contains('=')
+                               or (all_numeric and pos + 1 < cli_args.size()
+                                   and std::string_view{cli_args[pos + 1]}.find_first_of(",:") != std::string_view::npos);
+        if (not is_delimited) {
+            auto result = primitive_t{};
+            [&result, &next_value, option]<std::size_t ...I>(std::index_sequence<I...>) {
+                ([&result, &next_value, option] {
+                    using element_t = std::tuple_element_t<I, primitive_t>;
+                    auto const token = next_value(std::type_identity<element_t>{});
+                    auto element = parse_arg<element_t>(token);
+                    if (not element.has_value()) {
+                        throw wrong_option_type(fmt::format(
+                            "Option {} expects type {}, got {}", option, refl::type_name<primitive_t>(), token
+                        ));
+                    }
+                    std::get<I>(result) = std::move(*element);
+                }(), ...);
+            }(std::make_index_sequence<std::tuple_size_v<primitive_t>>());
+            return std::pair<std::size_t, T>{pos, std::move(result)};
+        }
+    }
+
+    auto const _value = [option, &next_value] {
+        if (auto idx = option.find('='); idx != std::string_view::npos) {
+            return option.substr(idx + 1);
+        }
+        return next_value(std::type_identity<T>{});
+    }();
+    if constexpr (refl::is_inplace_string<primitive_t>) {
+        if (_value.size() > primitive_t::capacity()) {
+            throw wrong_option_type(fmt::format(
+                "Option {} accepts at most {} characters, got {}", option, primitive_t::capacity(), _value.size()
+            ));
+        }
+    }
     auto result = parse_arg<T>(_value);
     if (not result.has_value()) {
         throw wrong_option_type(
-            fmt::format("Option {} expects type {}, got {}", *it, refl::type_name<T>(), _value)
+            fmt::format("Option {} expects type {}, got {}", option, refl::type_name<T>(), _value)
         );
     }
-    return std::pair<It, T>{std::move(it), std::move(*result)};
+    return std::pair<std::size_t, T>{pos, std::move(*result)};
 }
 
+namespace detail {
+inline constexpr auto no_match = std::numeric_limits<std::size_t>::max();
+inline constexpr auto ambiguous_match = no_match - 1;
+
+struct option_name
+{
+    std::string_view name;
+    std::size_t member;
+};
+
 /**
- * @brief Parses the argument list to get the desired struct
+ * @brief The position of the first parsing slot of each member of `Cli`, plus the total
  *
- * @tparam Cli the aggregate representing a struct
- * @param args the command line arguments
- * @return an object of type `Cli` filled with the data parsed from `args`
+ * Every member takes a slot, except `flag_set` members which take one slot per flag.
  */
 template <typename Cli>
-    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
-auto parse(std::span<char const * const> const cli_args)
-{
-    using buffer_t = refl::to_tuple_of_optionals<Cli>;
-    auto buffer = buffer_t{};
- 
-    reflect::for_each<Cli>([cli_args, &buffer](auto I) {
+constexpr inline auto slot_offsets = [] {
+    auto result = std::array<std::size_t, reflect::size<Cli>() + 1>{};
+    reflect::for_each<Cli>([&result](auto I) {
         using member_type = refl::member_type<Cli, I>;
-        constexpr auto long_name = cliar::long_name<Cli, I>().value_or("");
-        constexpr auto short_name = cliar::short_name<Cli, I>().value_or("");
-
-        auto it = std::ranges::find_if(cli_args, [=](char const * arg) {
-            auto str = std::string_view{arg};
-            if (not member_type::short_name_disabled) {
-                if (str.starts_with(short_name)) {
-                    if (str.size() == short_name.size()) {
-                        return true;
-                    }
-                    if (str.at(short_name.size()) == '=') {
-                        return true;
-                    }
-                }
-            }
-            auto is_long =  member_type::long_name_disabled ? false : str.starts_with(long_name);
-            return is_long;
-        });
-        if (it != cli_args.end()) {
-            using value_type = member_type::value_type;
-            constexpr auto is_opt_flag = std::is_same_v<value_type, bool>
-                                  or std::is_same_v<value_type, std::optional<bool>>;
-            if constexpr (is_opt_flag) {
-                auto const next_is_option = it + 1 != cli_args.end() 
-                                        and std::string_view{*(it + 1)}.starts_with("-");
-                if (next_is_option) {
-                    std::get<std::optional<member_type>>(buffer) = true;
-                    return;
-                }
-            }
-            auto [new_it, res] = parse_option<value_type>(it, short_name, long_name);
-            std::get<std::optional<member_type>>(buffer) = std::move(res);
-            it = std::move(new_it);
+        if constexpr (is_flag_set<member_type>) {
+            result[I + 1] = result[I] + member_type::size;
+        } else {
+            result[I + 1] = result[I] + 1;
         }
     });
+    return result;
+}();
+
+/**
+ * @brief Lists every enabled short and long name of `Clis`, together with its parsing slot
+ *
+ * Slots are numbered across all the types, in order: the first slot of the second type comes
+ * right after the last slot of the first one.
+ */
+template <typename ...Clis>
+constexpr auto option_names()
+{
+    auto result = std::vector<option_name>{};
+    auto offset = std::size_t{0};
+    auto add = [&result]<typename Aggregate>(std::type_identity<Aggregate>, auto I, std::size_t slot) {
+        if constexpr (constexpr auto name = cliar::long_name<Aggregate, I>(); name.has_value()) {
+            result.push_back(option_name{*name, slot});
+        }
+        if constexpr (constexpr auto name = cliar::short_name<Aggregate, I>(); name.has_value()) {
+            result.push_back(option_name{*name, slot});
+        }
+    };
+    ([&add, &offset] {
+        reflect::for_each<Clis>([&add, offset](auto I) {
+            using member_type = refl::member_type<Clis, I>;
+            auto const slot = offset + slot_offsets<Clis>[I];
+            if constexpr (is_flag_set<member_type>) {
+                using flags_t = member_type::flags_type;
+                reflect::for_each<flags_t>([&add, slot](auto J) { add(std::type_identity<flags_t>{}, J, slot + J); });
+            } else {
+                add(std::type_identity<Clis>{}, I, slot);
+            }
+        });
+        offset += slot_offsets<Clis>.back();
+    }(), ...);
+    return result;
+}
+
+/**
+ * @brief `option_names` as an array, usable at run time
+ */
+template <typename ...Clis>
+constexpr inline auto option_names_v = [] {
+    constexpr auto count = option_names<Clis...>().size();
+    auto result = std::array<option_name, count>{};
+    std::ranges::copy(option_names<Clis...>(), result.begin());
+    return result;
+}();
+
+/**
+ * @brief Dynamically sized trie, used at compile time to compute the shape of `option_trie`
+ *
+ * Node `0` is the root; every node lists its outgoing edges as `(character, child)` pairs.
+ */
+struct trie_builder
+{
+    std::vector<std::vector<std::pair<char, std::size_t>>> children{};
+    std::vector<std::size_t> terminal{};
+    std::vector<std::size_t> unique_long{};
+
+    constexpr explicit trie_builder(std::span<option_name const> names)
+    {
+        add_node();
+        for (auto const & [name, member] : names) {
+            auto const is_long = name.starts_with("--");
+            auto node = std::size_t{0};
+            for (auto depth = std::size_t{0}; depth < name.size(); ++depth) {
+                auto const & edges = children[node];
+                auto const edge = std::ranges::find(edges, name[depth], &std::pair<char, std::size_t>::first);
+                if (edge != edges.end()) {
+                    node = edge->second;
+                } else {
+                    auto const child = children.size();
+                    children[node].emplace_back(name[depth], child);
+                    add_node();
+                    node = child;
+                }
+                // A long name can be abbreviated to any prefix longer than "--"
+                if (is_long and depth >= 2) {
+                    auto & unique = unique_long[node];
+                    unique = (unique == no_match or unique == member) ? member : ambiguous_match;
+                }
+            }
+            terminal[node] = member;
+        }
+    }
+
+    constexpr auto add_node() -> void
+    {
+        children.emplace_back();
+        terminal.push_back(no_match);
+        unique_long.push_back(no_match);
+    }
+};
+
+/**
+ * @brief A trie over all the option names of a `Cli`, built at compile time
+ *
+ * Matching a token costs a single left-to-right scan, stopping at the first `=`, independently of
+ * the number of options. Edges are stored contiguously per node with 16-bit indices, so the whole
+ * table takes about five bytes per character of option names and stays in cache.
+ */
+template <std::size_t Nodes>
+struct option_trie
+{
+    static constexpr auto none = std::numeric_limits<std::uint16_t>::max();
+    static constexpr auto ambiguous = static_cast<std::uint16_t>(none - 1);
+    static_assert(Nodes < ambiguous, "too many option names");
+
+    /// The edges leaving node `n` are `label[i], target[i]` for `i` in `[first_edge[n], first_edge[n + 1])`
+    std::array<std::uint16_t, Nodes + 1> first_edge{};
+    std::array<char, Nodes - 1> label{};
+    std::array<std::uint16_t, Nodes - 1> target{};
+    std::array<std::uint16_t, Nodes> terminal{};
+    std::array<std::uint16_t, Nodes> unique_long{};
+
+    static constexpr auto narrow(std::size_t member) -> std::uint16_t
+    {
+        return member == no_match ? none : member == ambiguous_match ? ambiguous : static_cast<std::uint16_t>(member);
+    }
+
+    static constexpr auto widen(std::uint16_t member) -> std::size_t
+    {
+        return member == none ? no_match : member == ambiguous ? ambiguous_match : member;
+    }
+
+    /**
+     * @brief Finds the member whose name matches `token`
+     *
+     * @param token a command line argument, optionally in the form `name=value`
+     * @param allow_abbreviations whether an unambiguous prefix of a long name is accepted
+     * @return the index of the matched member, `no_match` or `ambiguous_match`
+     */
+    [[nodiscard]]
+    constexpr auto match(std::string_view token, bool allow_abbreviations) const -> std::size_t
+    {
+        auto node = std::size_t{0};
+        for (auto ch : token) {
+            if (ch == '=') {
+                break;
+            }
+            auto const first = label.begin() + first_edge[node];
+            auto const last = label.begin() + first_edge[node + 1];
+            auto const edge = std::find(first, last, ch);
+            if (edge == last) {
+                return no_match;
+            }
+            node = target[static_cast<std::size_t>(edge - label.begin())];
+        }
+        if (terminal[node] != none or not allow_abbreviations) {
+            return widen(terminal[node]);
+        }
+        return widen(unique_long[node]);
+    }
+};
+
+template <typename ...Clis>
+consteval auto build_option_trie()
+{
+    static constexpr auto names = option_names_v<Clis...>;
+    constexpr auto nodes = [] { return trie_builder{names}.children.size(); }();
+    using trie_t = option_trie<nodes>;
+    static_assert((slot_offsets<Clis>.back() + ... + 0) < trie_t::ambiguous, "too many options");
+
+    auto const builder = trie_builder{names};
+    auto trie = trie_t{};
+    auto edge = std::size_t{0};
+    for (auto node = std::size_t{0}; node < nodes; ++node) {
+        trie.first_edge[node] = static_cast<std::uint16_t>(edge);
+        for (auto const & [ch, child] : builder.children[node]) {
+            trie.label[edge] = ch;
+            trie.target[edge] = static_cast<std::uint16_t>(child);
+            ++edge;
+        }
+        trie.terminal[node] = trie_t::narrow(builder.terminal[node]);
+        trie.unique_long[node] = trie_t::narrow(builder.unique_long[node]);
+    }
+    trie.first_edge[nodes] = static_cast<std::uint16_t>(edge);
+    return trie;
+}
+
+template <typename ...Clis>
+constexpr inline auto option_trie_v = build_option_trie<Clis...>();
+
+/**
+ * @brief Lists the long names of `Clis` starting with `prefix`, used to report ambiguities
+ */
+template <typename ...Clis>
+auto abbreviation_candidates(std::string_view prefix) -> std::vector<std::string_view>
+{
+    constexpr auto & names = option_names_v<Clis...>;
+    auto result = std::vector<std::string_view>{};
+    for (auto const & [name, member] : names) {
+        if (name.starts_with("--") and name.starts_with(prefix)) {
+            result.push_back(name);
+        }
+    }
+    return result;
+}
+
+template <typename ...Clis>
+using parse_buffers = std::tuple<refl::to_tuple_of_optionals<Clis>...>;
+
+/**
+ * @brief Parses a boolean flag found at position `pos`
+ *
+ * A flag followed by another option, or by nothing, is `true`; otherwise it takes a value.
+ *
+ * @return the position of the last consumed token and the parsed value
+ */
+template <typename T, typename Arg>
+auto parse_flag(std::span<Arg const> const cli_args, std::size_t pos) -> std::pair<std::size_t, T>
+{
+    auto const has_value = std::string_view{cli_args[pos]}.contains('=');
+    auto const next_is_option = pos + 1 == cli_args.size()
+                             or std::string_view{cli_args[pos + 1]}.starts_with("-");
+    if (not has_value and next_is_option) {
+        return std::pair<std::size_t, T>{pos, true};
+    }
+    return parse_option<T>(cli_args, pos);
+}
+
+/**
+ * @brief Parses the `I`-th member of `Cli`, whose name was found at position `pos`
+ *
+ * Only the first occurrence of an option is stored; later ones are parsed and discarded.
+ *
+ * @tparam Arg the type of the arguments, either `char const *` or `std::string_view`
+ * @tparam Buffers the `parse_buffers` of all the types being parsed
+ * @tparam K the position of `Cli` in `Buffers`
+ * @return the position of the last consumed token
+ */
+template <typename Arg, typename Buffers, std::size_t K, typename Cli, std::size_t I>
+auto parse_member(Buffers & buffers, std::span<Arg const> const cli_args, std::size_t pos) -> std::size_t
+{
+    using value_type = refl::member_type<Cli, I>::value_type;
+    auto & slot = std::get<I>(std::get<K>(buffers));
+
+    auto [new_pos, res] = [cli_args, pos] {
+        if constexpr (refl::is_flag<value_type>) {
+            return parse_flag<value_type>(cli_args, pos);
+        } else {
+            return parse_option<value_type>(cli_args, pos);
+        }
+    }();
+    if (not slot.has_value()) {
+        slot = std::move(res);
+    }
+    return new_pos;
+}
+
+/**
+ * @brief Parses the `J`-th flag of the `flag_set` stored in the `I`-th member of `Cli`
+ *
+ * As for `parse_member`, only the first occurrence of a flag is stored.
+ */
+template <typename Arg, typename Buffers, std::size_t K, typename Cli, std::size_t I, std::size_t J>
+auto parse_packed_flag(Buffers & buffers, std::span<Arg const> const cli_args, std::size_t pos) -> std::size_t
+{
+    using flags_t = refl::member_type<Cli, I>;
+    using value_type = refl::member_type<typename flags_t::flags_type, J>::value_type;
+    auto & slot = std::get<I>(std::get<K>(buffers));
+
+    auto [new_pos, res] = parse_flag<value_type>(cli_args, pos);
+    auto & flags = slot.has_value() ? *slot : slot.emplace();
+    if (not flags.engaged()[J]) {
+        flags.template set<J>(res);
+    }
+    return new_pos;
+}
+
+template <typename Arg, typename Buffers>
+using member_parser = auto (*)(Buffers &, std::span<Arg const>, std::size_t) -> std::size_t;
+
+template <typename Arg, typename Buffers, std::size_t K, typename Cli>
+consteval auto member_parsers_of()
+{
+    auto result = std::array<member_parser<Arg, Buffers>, slot_offsets<Cli>.back()>{};
+    reflect::for_each<Cli>([&result](auto I) {
+        using member_type = refl::member_type<Cli, I>;
+        if constexpr (is_flag_set<member_type>) {
+            using index_t = decltype(I);
+            [&result]<std::size_t ...J>(std::index_sequence<J...>) {
+                constexpr auto first = slot_offsets<Cli>[index_t::value];
+                ((result[first + J] = &parse_packed_flag<Arg, Buffers, K, Cli, index_t::value, J>), ...);
+            }(std::make_index_sequence<member_type::size>());
+        } else {
+            result[slot_offsets<Cli>[I]] = &parse_member<Arg, Buffers, K, Cli, I>;
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief A table mapping each parsing slot of `Clis`, numbered as in `option_names`, to the
+ * function parsing that member or flag
+ */
+template <typename Arg, typename ...Clis>
+consteval auto member_parsers()
+{
+    using buffers_t = parse_buffers<Clis...>;
+    auto result = std::array<member_parser<Arg, buffers_t>, (slot_offsets<Clis>.back() + ... + 0)>{};
+    auto out = result.begin();
+    [&out]<std::size_t ...K>(std::index_sequence<K...>) {
+        ((out = std::ranges::copy(member_parsers_of<Arg, buffers_t, K, Clis>(), out).out), ...);
+    }(std::index_sequence_for<Clis...>());
+    return result;
+}
+
+/**
+ * @brief Fills the flags of `flags` not found by `parse` with their default value, and reports
+ * the missing required ones
+ */
+template <typename Flags>
+auto fill_flag_defaults(flag_set<Flags> & flags, std::vector<std::string_view> & missing) -> void
+{
+    reflect::for_each<Flags>([&flags, &missing](auto J) {
+        using value_t = refl::member_type<Flags, J>::value_type;
+        if (flags.engaged()[J]) {
+            return;
+        }
+        if constexpr (not refl::is_optional<value_t>) {
+            missing.push_back(display_name<Flags, J>());
+        } else if constexpr (refl::has_default_value<Flags, J>()) {
+            flags.template set<J>(refl::get_default_value<Flags, J>());
+        }
+    });
+}
+
+/**
+ * @brief Builds a `Cli` from the options found by `parse`
+ *
+ * Checks the constraints of `Cli`, fills the missing optional members with their default value
+ * and reports the missing required ones.
+ */
+template <typename Cli>
+auto finalize(refl::to_tuple_of_optionals<Cli> && buffer) -> Cli
+{
+    using buffer_t = refl::to_tuple_of_optionals<Cli>;
+
+    auto const seen = [&buffer]<std::size_t ...I>(std::index_sequence<I...>) {
+        auto result = std::bitset<sizeof...(I)>{};
+        ((result[I] = std::get<I>(buffer).has_value()), ...);
+        return result;
+    }(std::make_index_sequence<std::tuple_size_v<buffer_t>>());
+    check_constraints<Cli>(seen);
 
     auto missing = std::vector<std::string_view>{};
     [&buffer, &missing]<auto ...I>(std::index_sequence<I...>) {
         auto fn = [&, cli=Cli{}]<typename Idx>(Idx) {
             constexpr auto N = std::integral_constant<std::size_t, Idx::value>{};
-            if (auto const & v = std::get<N>(buffer); not v.has_value()) {
+            if constexpr (is_flag_set<refl::member_type<Cli, N>>) {
+                auto & flags = std::get<N>(buffer);
+                fill_flag_defaults(flags.has_value() ? *flags : flags.emplace(), missing);
+            } else if (auto const & v = std::get<N>(buffer); not v.has_value()) {
                 using Tp = std::tuple_element_t<N, buffer_t>;
                 using InnerTp = typename Tp::value_type::value_type;
                 if constexpr (refl::is_optional<InnerTp>) {
@@ -745,15 +1580,7 @@ auto parse(std::span<char const * const> const cli_args)
                         std::get<N>(buffer) = InnerTp{};
                     }
                 } else {
-                    if constexpr (not refl::member_type<Cli, N>::long_name_disabled) {
-                        auto ln = cliar::long_name_unconditional<Cli, N>();
-                        missing.push_back(ln);
-                    } else if constexpr (not refl::member_type<Cli, N>::short_name_disabled) {
-                        auto sn = cliar::short_name_unconditional<Cli, N>();
-                        missing.push_back(sn);
-                    } else {
-                        missing.push_back(reflect::member_name<N, Cli>());
-                    }
+                    missing.push_back(display_name<Cli, N>());
                 }
             }
         };
@@ -771,6 +1598,936 @@ auto parse(std::span<char const * const> const cli_args)
         return Cli{std::forward<Args>(args).value()...};
     }, std::move(buffer));
 }
+}  // namespace detail
+
+/**
+ * @brief Settings tweaking the behaviour of `parse`
+ */
+struct parse_settings
+{
+    /// Accept unambiguous prefixes of long names, e.g. `--only-l` for `--only-long`
+    bool allow_abbreviations = false;
+};
+
+namespace detail {
+template <typename Arg, typename Cli, typename ...Others>
+auto parse_impl(std::span<Arg const> const cli_args, parse_settings const settings)
+{
+    check_repeated_names<Cli, Others...>();
+    using buffers_t = parse_buffers<Cli, Others...>;
+    auto buffers = buffers_t{};
+
+    constexpr auto parsers = member_parsers<Arg, Cli, Others...>();
+    for (auto pos = std::size_t{0}; pos < cli_args.size(); ++pos) {
+        auto const str = std::string_view{cli_args[pos]};
+        if (str == "--") {
+            break;
+        }
+        if (not str.starts_with("-") or str == "-") {
+            continue;
+        }
+        auto const idx = option_trie_v<Cli, Others...>.match(str, settings.allow_abbreviations);
+        if (idx == ambiguous_match) {
+            auto const name = str.substr(0, str.find('='));
+            throw unknown_option(fmt::format(
+                "Ambiguous option '{}' (could be {})",
+                name, fmt::join(abbreviation_candidates<Cli, Others...>(name), ", ")
+            ));
+        }
+        if (idx == no_match) {
+            throw unknown_option(fmt::format("Unknown option '{}'", str));
+        }
+        pos = parsers[idx](buffers, cli_args, pos);
+    }
+
+    if constexpr (sizeof...(Others) == 0) {
+        return finalize<Cli>(std::get<0>(std::move(buffers)));
+    } else {
+        using result_t = std::tuple<Cli, Others...>;
+        return [&buffers]<std::size_t ...K>(std::index_sequence<K...>) {
+            return result_t{finalize<std::tuple_element_t<K, result_t>>(std::get<K>(std::move(buffers)))...};
+        }(std::index_sequence_for<Cli, Others...>());
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief Parses the argument list to get the desired struct
+ *
+ * Several aggregates can be parsed at once from the same arguments, e.g. when every library of a
+ * program declares its own options: their names must not clash, the arguments are scanned only
+ * once and only options claimed by none of them are reported as unknown.
+ * A lone `--` marks the end of the options: the arguments following it are left to the caller.
+ * ```cpp
+ * auto [log, net] = cliar::parse<log_args, net_args>(args);
+ * ```
+ *
+ * @tparam Cli the aggregate representing a struct
+ * @tparam Others further aggregates to be parsed from the same arguments
+ * @param args the command line arguments
+ * @param settings additional parsing settings
+ * @return an object of type `Cli` filled with the data parsed from `args`, or a tuple of
+ *         `Cli, Others...` if more than one type is given
+ */
+template <typename Cli, typename ...Others>
+    requires (std::is_aggregate_v<Cli> and members_are_cli_args<Cli>)
+         and ((std::is_aggregate_v<Others> and members_are_cli_args<Others>) and ...)
+auto parse(std::span<char const * const> const cli_args, parse_settings const settings = {})
+{
+    return detail::parse_impl<char const *, Cli, Others...>(cli_args, settings);
+}
+
+/**
+ * @brief Parses an argument list made of string views, e.g. produced by `tokenized_line`
+ */
+template <typename Cli, typename ...Others>
+    requires (std::is_aggregate_v<Cli> and members_are_cli_args<Cli>)
+         and ((std::is_aggregate_v<Others> and members_are_cli_args<Others>) and ...)
+auto parse(std::span<std::string_view const> const cli_args, parse_settings const settings = {})
+{
+    return detail::parse_impl<std::string_view, Cli, Others...>(cli_args, settings);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+constexpr inline auto snapshot_magic = std::array{std::byte{'c'}, std::byte{'l'}, std::byte{'i'}, std::byte{'r'}};
+constexpr inline auto snapshot_version = std::uint32_t{1};
+
+constexpr auto fnv1a(std::uint64_t hash, std::string_view str) -> std::uint64_t
+{
+    for (auto ch : str) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+constexpr auto fnv1a(std::uint64_t hash, std::uint64_t value) -> std::uint64_t
+{
+    for (auto i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+template <typename T>
+auto write_raw(std::vector<std::byte> & out, T const & value) -> void
+{
+    auto const bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(value);
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+template <typename T>
+auto read_raw(std::span<std::byte const> & in) -> T
+{
+    if (in.size() < sizeof(T)) {
+        throw invalid_snapshot("Truncated snapshot");
+    }
+    auto bytes = std::array<std::byte, sizeof(T)>{};
+    std::ranges::copy_n(in.begin(), sizeof(T), bytes.begin());
+    in = in.subspan(sizeof(T));
+    return std::bit_cast<T>(bytes);
+}
+
+template <typename T>
+auto write_value(std::vector<std::byte> & out, T const & value) -> void
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        out.push_back(static_cast<std::byte>(value));
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        write_raw(out, value);
+    } else if constexpr (std::is_same_v<T, std::string> or refl::is_inplace_string<T>) {
+        if (value.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw invalid_snapshot("String too long to be stored in a snapshot");
+        }
+        write_raw(out, static_cast<std::uint32_t>(value.size()));
+        auto const bytes = std::as_bytes(std::span{value.data(), value.size()});
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    } else if constexpr (refl::is_fixed_arity<T>) {
+        std::apply([&out](auto const & ...elements) { (write_value(out, elements), ...); }, value);
+    } else if constexpr (is_flag_set<T>) {
+        for (auto const * bits : {&value.values(), &value.engaged()}) {
+            for (auto i = std::size_t{0}; i < T::size; i += 8) {
+                auto byte = std::uint8_t{0};
+                for (auto bit = std::size_t{0}; bit < 8 and i + bit < T::size; ++bit) {
+                    byte |= static_cast<std::uint8_t>((*bits)[i + bit] << bit);
+                }
+                out.push_back(static_cast<std::byte>(byte));
+            }
+        }
+    } else if constexpr (refl::is_optional<T>) {
+        out.push_back(static_cast<std::byte>(value.has_value()));
+        if (value.has_value()) {
+            write_value(out, *value);
+        }
+    } else {
+        static_assert(false, "invalid type for serialization");
+    }
+}
+
+template <typename T>
+auto read_value(std::span<std::byte const> & in) -> T
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        auto const byte = read_raw<std::uint8_t>(in);
+        if (byte > 1) {
+            throw invalid_snapshot(fmt::format("Invalid boolean value {} in snapshot", byte));
+        }
+        return byte == 1;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return read_raw<T>(in);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        auto const size = read_raw<std::uint32_t>(in);
+        if (in.size() < size) {
+            throw invalid_snapshot("Truncated snapshot");
+        }
+        auto result = std::string(reinterpret_cast<char const *>(in.data()), size);
+        in = in.subspan(size);
+        return result;
+    } else if constexpr (refl::is_inplace_string<T>) {
+        auto const size = read_raw<std::uint32_t>(in);
+        if (size > T::capacity()) {
+            throw invalid_snapshot(fmt::format("String of size {} exceeds capacity {}", size, T::capacity()));
+        }
+        if (in.size() < size) {
+            throw invalid_snapshot("Truncated snapshot");
+        }
+        auto result = T{std::string_view{reinterpret_cast<char const *>(in.data()), size}};
+        in = in.subspan(size);
+        return result;
+    } else if constexpr (refl::is_fixed_arity<T>) {
+        auto result = T{};
+        std::apply([&in](auto & ...elements) {
+            ((elements = read_value<std::remove_cvref_t<decltype(elements)>>(in)), ...);
+        }, result);
+        return result;
+    } else if constexpr (is_flag_set<T>) {
+        auto bits = std::array<std::bitset<T::size>, 2>{};
+        for (auto & set : bits) {
+            for (auto i = std::size_t{0}; i < T::size; i += 8) {
+                auto const byte = read_raw<std::uint8_t>(in);
+                for (auto bit = std::size_t{0}; bit < 8 and i + bit < T::size; ++bit) {
+                    set[i + bit] = (byte >> bit) & 1u;
+                }
+            }
+        }
+        return T{bits[0], bits[1]};
+    } else if constexpr (refl::is_optional<T>) {
+        if (not read_value<bool>(in)) {
+            return std::nullopt;
+        }
+        return read_value<typename T::value_type>(in);
+    } else {
+        static_assert(false, "invalid type for serialization");
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief Computes a hash identifying the binary layout of a `Cli` snapshot
+ *
+ * The hash covers the name of the aggregate and the name, type and size of every member, so that
+ * a snapshot can only be loaded by a binary agreeing on the exact same `Cli` definition.
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @return the schema hash
+ */
+template <typename Cli>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
+consteval auto schema_hash() -> std::uint64_t
+{
+    auto hash = detail::fnv1a(0xcbf29ce484222325, reflect::type_name<Cli>());
+    reflect::for_each<Cli>([&hash](auto I) {
+        using member_type = refl::member_type<Cli, I>;
+        hash = detail::fnv1a(hash, reflect::member_name<I, Cli>());
+        if constexpr (is_flag_set<member_type>) {
+            hash = detail::fnv1a(hash, schema_hash<typename member_type::flags_type>());
+        } else {
+            hash = detail::fnv1a(hash, refl::type_name<typename member_type::value_type>());
+            hash = detail::fnv1a(hash, sizeof(typename member_type::value_type));
+        }
+    });
+    return hash;
+}
+
+/**
+ * @brief Stores a parsed `Cli` in a compact binary snapshot
+ *
+ * The snapshot starts with a magic number, a format version and the `schema_hash` of `Cli`,
+ * followed by every member in declaration order. Numbers are stored in native representation,
+ * so snapshots are meant to be exchanged between processes running on the same machine.
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @param cli the object to store
+ * @return the binary snapshot
+ */
+template <typename Cli>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
+auto serialize(Cli const & cli) -> std::vector<std::byte>
+{
+    auto out = std::vector<std::byte>{};
+    out.insert(out.end(), detail::snapshot_magic.begin(), detail::snapshot_magic.end());
+    detail::write_raw(out, detail::snapshot_version);
+    detail::write_raw(out, schema_hash<Cli>());
+    reflect::for_each<Cli>([&out, &cli](auto I) {
+        if constexpr (is_flag_set<refl::member_type<Cli, I>>) {
+            detail::write_value(out, reflect::get<I>(cli));
+        } else {
+            detail::write_value(out, reflect::get<I>(cli)._value);
+        }
+    });
+    return out;
+}
+
+/**
+ * @brief Loads a `Cli` from a snapshot created by `serialize`
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @param snapshot the binary snapshot, e.g. read from a pipe or a memory-mapped file
+ * @return the stored object
+ * @throw invalid_snapshot if the snapshot is truncated, corrupted or was created for another `Cli`
+ */
+template <typename Cli>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
+auto deserialize(std::span<std::byte const> snapshot) -> Cli
+{
+    auto magic = std::array<std::byte, detail::snapshot_magic.size()>{};
+    if (snapshot.size() < magic.size()) {
+        throw invalid_snapshot("Truncated snapshot");
+    }
+    std::ranges::copy_n(snapshot.begin(), magic.size(), magic.begin());
+    snapshot = snapshot.subspan(magic.size());
+    if (magic != detail::snapshot_magic) {
+        throw invalid_snapshot("Not a cliar snapshot");
+    }
+    if (auto version = detail::read_raw<std::uint32_t>(snapshot); version != detail::snapshot_version) {
+        throw invalid_snapshot(fmt::format(
+            "Unsupported snapshot version {} (expected {})", version, detail::snapshot_version
+        ));
+    }
+    if (auto hash = detail::read_raw<std::uint64_t>(snapshot); hash != schema_hash<Cli>()) {
+        throw invalid_snapshot(fmt::format(
+            "Snapshot was created for a different definition of {}", reflect::type_name<Cli>()
+        ));
+    }
+
+    auto cli = Cli{};
+    reflect::for_each<Cli>([&snapshot, &cli](auto I) {
+        using member_type = refl::member_type<Cli, I>;
+        if constexpr (is_flag_set<member_type>) {
+            reflect::get<I>(cli) = detail::read_value<member_type>(snapshot);
+        } else {
+            reflect::get<I>(cli)._value = detail::read_value<typename member_type::value_type>(snapshot);
+        }
+    });
+    if (not snapshot.empty()) {
+        throw invalid_snapshot(fmt::format("{} unexpected trailing bytes in snapshot", snapshot.size()));
+    }
+    return cli;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A member packing a group of boolean flags into bits
+ *
+ * `Flags` is an aggregate made only of `option<bool>` and `option<std::optional<bool>>` members.
+ * It only describes the flags: a `flag_set<Flags>` member of a `Cli` exposes them as options of
+ * the `Cli` itself, with the same names, help, defaults and parsing rules as plain boolean
+ * options, but `parse` stores each of them in a single bit, plus an `engaged` bit telling whether
+ * an optional flag has a value. Bit indices follow the declaration order of `Flags`.
+ * Constraints of the `Cli` may refer to the whole group, which counts as passed when any of its
+ * flags is.
+ * Example:
+ * ```cpp
+ * struct features
+ * {
+ *     cliar::option<std::optional<bool>, "enable the fast path"> fast_path = true;  // -f, --fast-path
+ *     cliar::option<std::optional<bool>> experimental;                               // -e, --experimental
+ * };
+ *
+ * struct cli_args
+ * {
+ *     cliar::option<int> jobs;
+ *     cliar::flag_set<features> toggles;
+ * };
+ *
+ * auto const cli = cliar::parse<cli_args>(args);  // e.g. `--jobs 4 --experimental`
+ * if (cli.toggles.get<"fast_path">()) { ... }
+ * static_assert(cliar::flag_set<features>::bit_index<"experimental">() == 1);
+ * ```
+ *
+ * @tparam Flags the aggregate describing the flags
+ */
+template <typename Flags>
+    requires valid_flag_group<Flags>
+class flag_set
+{
+    template <std::size_t Bit>
+    using value_t = refl::member_type<Flags, Bit>::value_type;
+
+public:
+    using flags_type = Flags;
+    static constexpr auto size = reflect::size<Flags>();
+
+    /**
+     * @brief The bit assigned to the flag named `Name`
+     */
+    template <reflect::fixed_string Name>
+    [[nodiscard]]
+    static consteval auto bit_index() -> std::size_t
+    {
+        return refl::member_index<Flags, Name>();
+    }
+
+    constexpr flag_set() = default;
+
+    /**
+     * @brief Packs the flags stored in `flags`
+     */
+    constexpr explicit flag_set(Flags const & flags)
+    {
+        reflect::for_each<Flags>([this, &flags](auto I) { set<I>(reflect::get<I>(flags)._value); });
+    }
+
+    /**
+     * @brief Builds a set from its raw bits, e.g. read from a snapshot
+     */
+    constexpr flag_set(std::bitset<size> const & values, std::bitset<size> const & engaged)
+        : _values{values & engaged}, _engaged{engaged}
+    {}
+
+    /**
+     * @brief Reads the flag at bit `Bit`
+     *
+     * @return a `bool` for required flags, a `std::optional<bool>` for optional ones
+     */
+    template <std::size_t Bit>
+    [[nodiscard]]
+    constexpr auto get() const -> value_t<Bit>
+    {
+        if constexpr (refl::is_optional<value_t<Bit>>) {
+            return _engaged[Bit] ? std::optional<bool>{_values[Bit]} : std::nullopt;
+        } else {
+            return _values[Bit];
+        }
+    }
+
+    /**
+     * @brief Reads the flag named `Name`
+     */
+    template <reflect::fixed_string Name>
+    [[nodiscard]]
+    constexpr auto get() const -> value_t<bit_index<Name>()>
+    {
+        return get<bit_index<Name>()>();
+    }
+
+    /**
+     * @brief Overwrites the flag at bit `Bit`
+     */
+    template <std::size_t Bit>
+    constexpr auto set(value_t<Bit> value) -> void
+    {
+        if constexpr (refl::is_optional<value_t<Bit>>) {
+            _engaged[Bit] = value.has_value();
+            _values[Bit] = value.value_or(false);
+        } else {
+            _engaged[Bit] = true;
+            _values[Bit] = value;
+        }
+    }
+
+    /**
+     * @brief Overwrites the flag named `Name`
+     */
+    template <reflect::fixed_string Name>
+    constexpr auto set(value_t<bit_index<Name>()> value) -> void
+    {
+        set<bit_index<Name>()>(value);
+    }
+
+    [[nodiscard]] constexpr auto values() const -> std::bitset<size> const & { return _values; }
+    [[nodiscard]] constexpr auto engaged() const -> std::bitset<size> const & { return _engaged; }
+
+    friend constexpr bool operator==(flag_set const &, flag_set const &) = default;
+
+private:
+    std::bitset<size> _values;
+    std::bitset<size> _engaged;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+constexpr auto is_blank(char ch) -> bool { return ch == ' ' or (ch >= '\t' and ch <= '\r'); }
+constexpr auto is_special(char ch) -> bool { return is_blank(ch) or ch == '"' or ch == '\'' or ch == '\\'; }
+
+/**
+ * @brief Finds the first whitespace, quote or backslash in `[first, last)`
+ *
+ * Uses AVX2 or SSE2 when enabled at compile time, falling back to a scalar scan for the tail.
+ */
+inline auto find_special(char const * first, char const * const last) -> char const *
+{
+#if defined(__AVX2__)
+    auto const control_first = _mm256_set1_epi8('\t');
+    auto const control_span = _mm256_set1_epi8('\r' - '\t');
+    auto const space = _mm256_set1_epi8(' ');
+    auto const double_quote = _mm256_set1_epi8('"');
+    auto const single_quote = _mm256_set1_epi8('\'');
+    auto const backslash = _mm256_set1_epi8('\\');
+    for (; last - first >= 32; first += 32) {
+        auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(first));
+        // '\t' <= ch <= '\r', as an unsigned comparison
+        auto const control = _mm256_sub_epi8(chunk, control_first);
+        auto const is_control = _mm256_cmpeq_epi8(_mm256_min_epu8(control, control_span), control);
+        auto const is_quote = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, double_quote),
+                                              _mm256_cmpeq_epi8(chunk, single_quote));
+        auto const is_other = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                                              _mm256_cmpeq_epi8(chunk, backslash));
+        auto const mask = _mm256_or_si256(is_control, _mm256_or_si256(is_quote, is_other));
+        if (auto const bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(mask)); bits != 0) {
+            return first + std::countr_zero(bits);
+        }
+    }
+#elif defined(__SSE2__)
+    auto const control_first = _mm_set1_epi8('\t');
+    auto const control_span = _mm_set1_epi8('\r' - '\t');
+    auto const space = _mm_set1_epi8(' ');
+    auto const double_quote = _mm_set1_epi8('"');
+    auto const single_quote = _mm_set1_epi8('\'');
+    auto const backslash = _mm_set1_epi8('\\');
+    for (; last - first >= 16; first += 16) {
+        auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        // '\t' <= ch <= '\r', as an unsigned comparison
+        auto const control = _mm_sub_epi8(chunk, control_first);
+        auto const is_control = _mm_cmpeq_epi8(_mm_min_epu8(control, control_span), control);
+        auto const is_quote = _mm_or_si128(_mm_cmpeq_epi8(chunk, double_quote),
+                                           _mm_cmpeq_epi8(chunk, single_quote));
+        auto const is_other = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                           _mm_cmpeq_epi8(chunk, backslash));
+        auto const mask = _mm_or_si128(is_control, _mm_or_si128(is_quote, is_other));
+        if (auto const bits = static_cast<std::uint32_t>(_mm_movemask_epi8(mask)); bits != 0) {
+            return first + std::countr_zero(bits);
+        }
+    }
+#endif
+    return std::find_if(first, last, is_special);
+}
+
+/**
+ * @brief Copies the token starting at `first` into `out`, removing quotes and escapes
+ *
+ * `[first, special)` is known to contain no special character.
+ * Single quotes preserve everything; inside double quotes a backslash only escapes `"` and `\`.
+ *
+ * @return the end of the token in the input and the end of the written output
+ */
+inline auto copy_unquoted(char const * first, char const * special, char const * const last, char * out)
+    -> std::pair<char const *, char *>
+{
+    out = std::copy(first, special, out);
+    auto quote = '\0';
+    auto it = special;
+    for (; it != last; ++it) {
+        auto const ch = *it;
+        if (quote == '\'') {
+            if (ch == '\'') { quote = '\0'; } else { *out++ = ch; }
+        } else if (ch == '\\') {
+            if (++it == last) {
+                throw malformed_command_line("Command line ends with a backslash");
+            }
+            if (quote == '"' and *it != '"' and *it != '\\') {
+                *out++ = '\\';
+            }
+            *out++ = *it;
+        } else if (quote == '"') {
+            if (ch == '"') { quote = '\0'; } else { *out++ = ch; }
+        } else if (ch == '"' or ch == '\'') {
+            quote = ch;
+        } else if (is_blank(ch)) {
+            break;
+        } else {
+            *out++ = ch;
+        }
+    }
+    if (quote != '\0') {
+        throw malformed_command_line(fmt::format("Unterminated {} in command line", quote));
+    }
+    return {it, out};
+}
+
+/**
+ * @brief Splits `line` into arguments, following shell-style quoting rules
+ *
+ * @param push called with every argument
+ * @param buffer called at most once, the first time an argument must be unquoted; returns the
+ *        storage for the unquoted text, of at least `line.size()` characters
+ */
+template <typename Push, typename Buffer>
+auto tokenize(std::string_view line, Push && push, Buffer && buffer) -> void
+{
+    auto it = line.data();
+    auto const last = it + line.size();
+    auto out = static_cast<char *>(nullptr);
+    while (true) {
+        while (it != last and is_blank(*it)) {
+            ++it;
+        }
+        if (it == last) {
+            break;
+        }
+
+        auto const start = it;
+        it = find_special(it, last);
+        if (it == last or is_blank(*it)) {
+            push(std::string_view{start, it});
+            continue;
+        }
+
+        // The whole argument is a single quoted string: no need to copy it
+        if (it == start and *it != '\\') {
+            auto const quote = *it;
+            auto const close = std::find_if(it + 1, last, [quote](char ch) {
+                return ch == quote or (quote == '"' and ch == '\\');
+            });
+            if (close != last and *close == quote and (close + 1 == last or is_blank(close[1]))) {
+                push(std::string_view{it + 1, close});
+                it = close + 1;
+                continue;
+            }
+        }
+
+        // Unquoted text is never longer than the line, so the buffer is requested only once
+        if (out == nullptr) {
+            out = buffer();
+        }
+        auto const token = out;
+        std::tie(it, out) = copy_unquoted(start, it, last, out);
+        push(std::string_view{token, out});
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief A command line split into arguments, following shell-style quoting rules
+ *
+ * Arguments are views into the original line whenever possible; only arguments whose quotes or
+ * escapes must be removed from the middle of the text are copied, into a buffer owned by this
+ * object. The line must therefore outlive the `tokenized_line`.
+ * The argument list and the buffer are allocated on the heap; see `inplace_tokenized_line` for an
+ * allocation-free alternative.
+ * Example:
+ * ```cpp
+ * auto const line = cliar::tokenized_line{R"(--short "a b" -t 3)"};  // "--short", "a b", "-t", "3"
+ * ```
+ */
+class tokenized_line
+{
+public:
+    explicit tokenized_line(std::string_view line)
+    {
+        detail::tokenize(
+            line,
+            [this](std::string_view arg) { _args.push_back(arg); },
+            [this, size = line.size()] {
+                _buffer = std::make_unique_for_overwrite<char[]>(size);
+                return _buffer.get();
+            }
+        );
+    }
+
+    [[nodiscard]]
+    auto args() const noexcept -> std::span<std::string_view const> { return _args; }
+
+private:
+    std::unique_ptr<char[]> _buffer;
+    std::vector<std::string_view> _args;
+};
+
+/**
+ * @brief A `tokenized_line` with fixed capacity, which never allocates
+ *
+ * Meant for hot paths re-parsing many short command lines: keep one object around, or create it
+ * on the stack, and pass its `args()` to `parse`.
+ * ```cpp
+ * auto const line = cliar::inplace_tokenized_line<16>{record};
+ * auto const cli = cliar::parse<cli_args>(line.args());
+ * ```
+ *
+ * @tparam MaxArgs the maximum number of arguments
+ * @tparam BufferSize the maximum length of a line containing arguments that must be unquoted
+ * @throw malformed_command_line if the line exceeds the capacity
+ */
+template <std::size_t MaxArgs, std::size_t BufferSize = 1024>
+class inplace_tokenized_line
+{
+public:
+    explicit inplace_tokenized_line(std::string_view line)
+    {
+        detail::tokenize(
+            line,
+            [this](std::string_view arg) {
+                if (_size == MaxArgs) {
+                    throw malformed_command_line(fmt::format("Command line has more than {} arguments", MaxArgs));
+                }
+                _args[_size++] = arg;
+            },
+            [this, size = line.size()] {
+                if (size > BufferSize) {
+                    throw malformed_command_line(fmt::format(
+                        "Command line of {} characters exceeds the unquoting buffer of {}", size, BufferSize
+                    ));
+                }
+                return _buffer.data();
+            }
+        );
+    }
+
+    inplace_tokenized_line(inplace_tokenized_line const &) = delete;
+    auto operator=(inplace_tokenized_line const &) -> inplace_tokenized_line & = delete;
+
+    [[nodiscard]]
+    auto args() const noexcept -> std::span<std::string_view const> { return std::span{_args}.first(_size); }
+
+private:
+    std::array<std::string_view, MaxArgs> _args;
+    std::size_t _size = 0;
+    std::array<char, BufferSize> _buffer;
+};
+
+/**
+ * @brief Parses a single command line, e.g. a record read from a queue
+ *
+ * The line is split with a `tokenized_line`, which allocates; on hot paths use an
+ * `inplace_tokenized_line` and `parse` instead.
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @param line the command line, using shell-style quoting
+ * @param settings additional parsing settings
+ * @return the same result as `parse<Cli, Others...>`
+ */
+template <typename Cli, typename ...Others>
+    requires (std::is_aggregate_v<Cli> and members_are_cli_args<Cli>)
+         and ((std::is_aggregate_v<Others> and members_are_cli_args<Others>) and ...)
+auto parse_line(std::string_view line, parse_settings const settings = {})
+{
+    auto const tokens = tokenized_line{line};
+    return parse<Cli, Others...>(tokens.args(), settings);
+}
+
+/**
+ * @brief Lazily parses a buffer containing one command line per line
+ *
+ * Blank lines are skipped. Each line is parsed when the resulting view is iterated, so errors are
+ * thrown during the iteration.
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @param text the buffer, e.g. a memory-mapped file; it must outlive the returned view
+ * @param settings additional parsing settings
+ * @return a view of `Cli` objects, one per non-blank line
+ */
+template <typename Cli>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
+auto parse_lines(std::string_view text, parse_settings const settings = {})
+{
+    return text
+        | std::views::split('\n')
+        | std::views::transform([](auto && line) { return std::string_view{line.begin(), line.end()}; })
+        | std::views::filter([](std::string_view line) { return not std::ranges::all_of(line, detail::is_blank); })
+        | std::views::transform([settings](std::string_view line) { return parse_line<Cli>(line, settings); });
+}
+
+/**
+ * @brief Parses every line read from `input`, passing the result to `callback`
+ *
+ * Blank lines are skipped.
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @param input the stream to read, e.g. a pipe
+ * @param callback a function called with each parsed `Cli`
+ * @param settings additional parsing settings
+ */
+template <typename Cli, typename Fn>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli> and std::invocable<Fn &, Cli &&>
+auto parse_lines(std::istream & input, Fn && callback, parse_settings const settings = {}) -> void
+{
+    auto line = std::string{};
+    while (std::getline(input, line)) {
+        if (std::ranges::all_of(line, detail::is_blank)) {
+            continue;
+        }
+        std::invoke(callback, parse_line<Cli>(line, settings));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+inline auto append_json_string(std::string & out, std::string_view str) -> void
+{
+    out.push_back('"');
+    for (auto ch : str) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(ch));
+            } else {
+                out.push_back(ch);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+template <typename T>
+auto append_json_value(std::string & out, T const & value) -> void
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        out += value ? "true" : "false";
+    } else if constexpr (std::is_floating_point_v<T>) {
+        // JSON cannot represent infinities and NaN
+        if (std::isfinite(value)) {
+            fmt::format_to(std::back_inserter(out), "{}", value);
+        } else {
+            out += "null";
+        }
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        // `+` promotes `char`-sized integers, which would otherwise be printed as characters
+        fmt::format_to(std::back_inserter(out), "{}", +value);
+    } else if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+        append_json_string(out, std::string_view{value});
+    } else if constexpr (refl::is_fixed_arity<T>) {
+        std::apply([&out](auto const & first, auto const & ...rest) {
+            out.push_back('[');
+            append_json_value(out, first);
+            ((out += ", ", append_json_value(out, rest)), ...);
+            out.push_back(']');
+        }, value);
+    } else if constexpr (refl::is_optional<T>) {
+        if (value.has_value()) {
+            append_json_value(out, *value);
+        } else {
+            out += "null";
+        }
+    } else {
+        static_assert(false, "invalid type for serialization");
+    }
+}
+
+constexpr auto constraint_kind_name(constraint_kind kind) -> std::string_view
+{
+    switch (kind) {
+    case constraint_kind::at_most_one_of: return "at_most_one_of";
+    case constraint_kind::exactly_one_of: return "exactly_one_of";
+    case constraint_kind::at_least_one_of: return "at_least_one_of";
+    case constraint_kind::requires_all: return "requires_all";
+    }
+    return "";
+}
+}  // namespace detail
+
+/**
+ * @brief Describes the options of `Cli` as a JSON document
+ *
+ * The schema lists, for every member, its option names, type, whether it is required, its default
+ * value and its description, followed by the constraints of `Cli`. It lets external tools validate
+ * a command line without spawning the program; see `cliar_add_schema` in
+ * `cmake/cliar_schema.cmake` to write it at build time.
+ * Example output:
+ * ```json
+ * {"type": "cli_args", "hash": "0x...", "options": [
+ *   {"member": "set_both", "long_name": "--both", "short_name": "-b", "type": "optional<int>",
+ *    "required": false, "default": 100, "description": "both option names fixed"}
+ * ], "constraints": []}
+ * ```
+ *
+ * @tparam Cli the aggregate representing the CLI arguments
+ * @return the JSON schema
+ */
+template <typename Cli>
+    requires std::is_aggregate_v<Cli> and members_are_cli_args<Cli>
+auto schema() -> std::string
+{
+    auto out = std::string{R"({"type": )"};
+    detail::append_json_string(out, reflect::type_name<Cli>());
+    fmt::format_to(std::back_inserter(out), R"(, "hash": "{:#018x}", "options": [)", schema_hash<Cli>());
+
+    auto first_option = true;
+    auto describe = [&out, &first_option]<typename Aggregate>(std::type_identity<Aggregate>, auto I,
+                                                              std::string_view group) {
+        using member_type = refl::member_type<Aggregate, I>;
+        using value_t = member_type::value_type;
+        constexpr auto long_name = cliar::long_name<Aggregate, I>();
+        constexpr auto short_name = cliar::short_name<Aggregate, I>();
+
+        out += std::exchange(first_option, false) ? "\n  " : ",\n  ";
+        out += R"({"member": )";
+        // Flags of a `flag_set` are named after the group, e.g. `features.fast_path`
+        detail::append_json_string(out, group.empty()
+            ? std::string{reflect::member_name<I, Aggregate>()}
+            : fmt::format("{}.{}", group, reflect::member_name<I, Aggregate>()));
+        out += R"(, "long_name": )";
+        detail::append_json_value(out, long_name);
+        out += R"(, "short_name": )";
+        detail::append_json_value(out, short_name);
+        out += R"(, "type": )";
+        detail::append_json_string(out, refl::type_name<value_t>());
+        out += R"(, "required": )";
+        detail::append_json_value(out, not refl::is_optional<value_t>);
+        out += R"(, "default": )";
+        if constexpr (refl::has_default_value<Aggregate, I>()) {
+            detail::append_json_value(out, refl::get_default_value<Aggregate, I>());
+        } else {
+            out += "null";
+        }
+        out += R"(, "description": )";
+        detail::append_json_string(out, member_type::description());
+        out += "}";
+    };
+    reflect::for_each<Cli>([&describe](auto I) {
+        using member_type = refl::member_type<Cli, I>;
+        if constexpr (is_flag_set<member_type>) {
+            using flags_t = member_type::flags_type;
+            auto const group = reflect::member_name<I, Cli>();
+            reflect::for_each<flags_t>([&describe, group](auto J) {
+                describe(std::type_identity<flags_t>{}, J, group);
+            });
+        } else {
+            describe(std::type_identity<Cli>{}, I, {});
+        }
+    });
+
+    out += R"(], "constraints": [)";
+    auto first = true;
+    for (auto const & [kind, trigger, members] : detail::constraint_masks<Cli>) {
+        out += std::exchange(first, false) ? "\n  " : ",\n  ";
+        out += R"({"kind": )";
+        detail::append_json_string(out, detail::constraint_kind_name(kind));
+        out += R"(, "options": [)";
+        // For `requires_all`, the option requiring the others comes first
+        auto names = detail::names_in_mask<Cli>(trigger);
+        std::ranges::copy(detail::names_in_mask<Cli>(members), std::back_inserter(names));
+        for (auto i = std::size_t{0}; i < names.size(); ++i) {
+            out += i == 0 ? "" : ", ";
+            detail::append_json_string(out, names[i]);
+        }
+        out += "]}";
+    }
+    out += "]}";
+    return out;
+}
 
 } // namespace cliar
 
@@ -784,6 +2541,15 @@ struct fmt::formatter<reflect::fixed_string<T, N>> : fmt::formatter<std::string_
     }
 };
 
+template <std::size_t N>
+struct fmt::formatter<cliar::inplace_string<N>> : fmt::formatter<std::string_view>
+{
+    constexpr auto format(cliar::inplace_string<N> const & str, auto & ctx) const
+    {
+        return fmt::formatter<std::string_view>::format(std::string_view{str}, ctx);
+    }
+};
+
 template <typename T, auto ...Args>
 struct fmt::formatter<cliar::option<T, Args...>> : public fmt::formatter<T>
 {
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Generates the worst-case corpus used by `cliar_latency_check`.
+#
+# Every file starts with a byte selecting the Cli shape of parse_fuzzer.cpp (0: mixed_args,
+# 1: prefix_args with abbreviations, 2: mixed_args + log_args, 3: mixed_args from a single line),
+# followed by the arguments separated by '\0', or by the command line for shape 3.
+# Inputs named `rejected_*` must be rejected by their last token, all the others must parse.
+#
+# Usage: generate_corpus.py [output directory]   # defaults to the corpus next to this script
+
+import pathlib
+import sys
+
+
+def write(directory, name, shape, args=None, line=None):
+    payload = line.encode() if line is not None else b'\0'.join(arg.encode() for arg in args)
+    (directory / name).write_bytes(bytes([shape]) + payload)
+
+
+def main():
+    here = pathlib.Path(__file__).resolve().parent
+    directory = pathlib.Path(sys.argv[1]) if len(sys.argv) > 1 else here / 'corpus'
+    directory.mkdir(parents=True, exist_ok=True)
+
+    # Very long tokens
+    write(directory, 'long_string_value', 0, ['--string-value', 'a' * 65536])
+    write(directory, 'rejected_long_unknown_option', 0, ['--' + 'x' * 65536])
+    write(directory, 'rejected_long_inplace_value', 0, ['-o', 'b' * 65536])
+    write(directory, 'long_line', 3, line='--string-value ' + 'c' * 65536)
+
+    # Thousands of tokens, many of them containing '='
+    write(directory, 'many_equals', 0, ['--int-value=12345', '--float-value=1.5', '--string-value=abc=def'] * 2000)
+    write(directory, 'many_arrays', 0, ['--tile=1,2,3', '--range=10:20.5', '--tile', '4', '5', '6'] * 1500)
+    write(directory, 'many_flags', 0, ['-v'] * 8000)
+    write(directory, 'multi_struct', 2, ['--log-level=3', '-i', '7', '--verbose'] * 2000)
+    write(directory, 'quoted_line', 3, line=' '.join(
+        ['--string-value "quoted value with spaces" -i 3 --tile=1,2,3 -o \'x\\y\' -s a\\ b'] * 1000
+    ))
+
+    # Options with long common prefixes
+    prefix = '--common-long-prefix-for-option-'
+    names = ['alpha', 'bravo', 'charlie', 'delta', 'echo', 'foxtrot', 'golf', 'hotel',
+             'india', 'juliett', 'kilo', 'lima', 'mike', 'november', 'oscar', 'papa']
+    write(directory, 'common_prefix_exact', 1, [prefix + 'hotel=1', prefix + 'papa', '2'] * 2000)
+    # Every abbreviation length, from the first letter after the prefix to the full name
+    abbreviations = [prefix + name[:length] + '=1' for name in names for length in range(1, len(name) + 1)]
+    write(directory, 'common_prefix_abbreviated', 1, abbreviations * 40)
+    write(directory, 'rejected_common_prefix_ambiguous', 1, [prefix + 'hotel=1'] * 4000 + [prefix])
+
+if __name__ == '__main__':
+    main()
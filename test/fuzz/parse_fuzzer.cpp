@@ -0,0 +1,190 @@
+/**
+ * @author      : rbrugo (brugo.riccardo@gmail.com)
+ * @file        : parse_fuzzer
+ * @created     : Sunday Oct 18, 2026 15:31:08 CEST
+ * @description : libFuzzer / AFL harness for `parse`, and latency checker for the worst-case corpus
+ *
+ * Input format: the first byte selects the shape of the `Cli` being parsed, the remaining bytes
+ * are the arguments separated by '\0' (or a single shell-style command line, for shape 3).
+ * The corpus of worst-case inputs is generated by `generate_corpus.py`.
+ *
+ * When built without `CLIAR_LIBFUZZER`, a standalone driver is provided:
+ *     cliar_parse_corpus [--budget-ns-per-token N] <files or directories>...
+ * It parses every input, prints the time spent per input and per token, and fails if any input
+ * exceeds the budget, if an input named `rejected_*` is accepted or if any other input is
+ * rejected. The same binary can be used with AFL in file mode (`@@`).
+ */
+
+#include "cliar.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+struct mixed_args
+{
+    cliar::option<std::optional<bool>> verbose;
+    cliar::option<std::optional<int>> int_value;
+    cliar::option<std::optional<double>> float_value;
+    cliar::option<std::optional<std::string>> string_value;
+    cliar::option<std::optional<cliar::inplace_string<16>>, "--", "-o"> only_short;
+    cliar::option<std::optional<std::array<int, 3>>> tile;
+    cliar::option<std::optional<std::tuple<int, float>>> range;
+};
+
+// Long names sharing a long common prefix, parsed with abbreviations enabled; the first letter
+// after the prefix is enough to tell them apart
+struct prefix_args
+{
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-alpha"> alpha;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-bravo"> bravo;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-charlie"> charlie;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-delta"> delta;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-echo"> echo;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-foxtrot"> foxtrot;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-golf"> golf;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-hotel"> hotel;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-india"> india;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-juliett"> juliett;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-kilo"> kilo;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-lima"> lima;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-mike"> mike;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-november"> november;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-oscar"> oscar;
+    cliar::option<std::optional<int>, "-", "--common-long-prefix-for-option-papa"> papa;
+};
+
+struct log_args
+{
+    cliar::option<std::optional<int>, "-", "--log-level"> log_level = 2;
+};
+
+auto split_arguments(std::string_view text) -> std::vector<std::string_view>
+{
+    auto result = std::vector<std::string_view>{};
+    for (auto && arg : text | std::views::split('\0')) {
+        result.emplace_back(arg.begin(), arg.end());
+    }
+    return result;
+}
+
+struct outcome
+{
+    std::size_t tokens = 0;
+    bool accepted = false;
+};
+
+/**
+ * @brief Parses a single input
+ *
+ * @return the number of arguments in the input and whether it was accepted
+ */
+auto run_one(std::uint8_t const * data, std::size_t size) -> outcome
+{
+    if (size == 0) {
+        return {};
+    }
+    auto const shape = data[0] % 4;
+    auto const text = std::string_view{reinterpret_cast<char const *>(data) + 1, size - 1};
+    auto count = std::size_t{0};
+    try {
+        if (shape == 3) {
+            // A single shell-style line: count the arguments it is split into
+            auto const line = cliar::tokenized_line{text};
+            count = line.args().size();
+            static_cast<void>(cliar::parse<mixed_args>(line.args()));
+            return {count, true};
+        }
+        auto const args = split_arguments(text);
+        count = args.size();
+        switch (shape) {
+        case 0: static_cast<void>(cliar::parse<mixed_args>(args)); break;
+        case 1: static_cast<void>(cliar::parse<prefix_args>(args, {.allow_abbreviations = true})); break;
+        case 2: static_cast<void>(cliar::parse<mixed_args, log_args>(args)); break;
+        }
+    } catch (std::invalid_argument const &) {
+        // Every cliar exception derives from `std::invalid_argument`: rejecting an input is fine
+        return {count, false};
+    }
+    return {count, true};
+}
+
+#ifndef CLIAR_LIBFUZZER
+auto read_file(std::filesystem::path const & path) -> std::vector<std::uint8_t>
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+auto collect_inputs(std::span<char * const> paths) -> std::vector<std::filesystem::path>
+{
+    auto result = std::vector<std::filesystem::path>{};
+    for (auto const * path : paths) {
+        if (std::filesystem::is_directory(path)) {
+            for (auto const & entry : std::filesystem::directory_iterator{path}) {
+                if (entry.is_regular_file()) {
+                    result.push_back(entry.path());
+                }
+            }
+        } else {
+            result.emplace_back(path);
+        }
+    }
+    std::ranges::sort(result);
+    return result;
+}
+#endif
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const * data, std::size_t size)
+{
+    run_one(data, size);
+    return 0;
+}
+
+#ifndef CLIAR_LIBFUZZER
+int main(int argc, char * argv[])
+{
+    constexpr auto repetitions = 5;
+    auto args = std::span{argv + 1, argv + argc};
+    auto budget = std::optional<double>{};
+    if (args.size() >= 2 and std::string_view{args[0]} == "--budget-ns-per-token") {
+        budget = cliar::parse_arg<double>(args[1]);
+        if (not budget.has_value()) {
+            fmt::print(stderr, "Invalid budget '{}'\n", args[1]);
+            return 2;
+        }
+        args = args.subspan(2);
+    }
+
+    auto failed = false;
+    for (auto const & path : collect_inputs(args)) {
+        auto const input = read_file(path);
+        auto result = run_one(input.data(), input.size());
+
+        // The fastest of a few runs, to filter out noise
+        auto best = std::chrono::nanoseconds::max();
+        for (auto i = 0; i < repetitions; ++i) {
+            auto const start = std::chrono::steady_clock::now();
+            result = run_one(input.data(), input.size());
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start
+            ));
+        }
+
+        // Rejected inputs fail on their last token, so that every token is processed
+        auto const name = path.filename().string();
+        auto const unexpected = result.accepted == name.starts_with("rejected_");
+        auto const per_token = static_cast<double>(best.count()) / static_cast<double>(std::max(result.tokens, std::size_t{1}));
+        auto const over_budget = budget.has_value() and per_token > *budget;
+        failed = failed or over_budget or unexpected;
+        fmt::print("{:<36} {:>8} tokens {:>12} ns {:>10.1f} ns/token{}{}\n",
+                   name, result.tokens, best.count(), per_token,
+                   over_budget ? "  OVER BUDGET" : "",
+                   unexpected ? (result.accepted ? "  UNEXPECTEDLY ACCEPTED" : "  UNEXPECTEDLY REJECTED") : "");
+    }
+    return failed ? 1 : 0;
+}
+#endif
@@ -6,10 +6,34 @@
  */
 
 #include "cliar.hpp"
+#include "schema_args.hpp"
 #include <fmt/std.h>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace
+{
+// Counts heap allocations, to check the allocation-free parsing paths
+std::size_t allocations = 0;
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto * ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
 
 struct cli_args
 {
+    using constraints = std::tuple<cliar::at_most_one_of<"only_long", "only_short">>;
+
     cliar::option<bool> verbose;  // simple flag
     cliar::option<std::optional<bool>, "optional flag with comment"> with_comment = false;
 
@@ -19,9 +43,59 @@ struct cli_args
     cliar::option<std::optional<int>, "-b", "--both", "both option names fixed"> set_both = 100;
     cliar::option<std::optional<float>, "-", "--only-long", "disable short option"> only_long;
     cliar::option<std::optional<std::string>, "--", "-o", "disable long option"> only_short;
+    cliar::option<std::optional<cliar::inplace_string<8>>, "-", "--label", "fixed capacity string"> label = "none";
     // cliar::option<int, "--", "-", "can't disable both long and short"> i_wont_compile;
 };
 
+struct shape_args
+{
+    cliar::option<std::array<int, 3>, "size of a tile"> tile;
+    cliar::option<std::optional<std::tuple<int, float>>> range;
+    cliar::option<std::optional<std::array<std::string, 2>>, "-", "--hosts"> hosts;
+};
+
+struct hot_args
+{
+    cliar::option<std::optional<bool>> verbose;
+    cliar::option<int> count;
+    cliar::option<std::optional<double>> ratio = 0.5;
+    cliar::option<std::optional<cliar::inplace_string<16>>, "-", "--name"> name;
+};
+
+struct connection_args
+{
+    using constraints = std::tuple<
+        cliar::exactly_one_of<"tcp", "udp">,
+        cliar::at_least_one_of<"host", "socket">,
+        cliar::requires_all<"user", "password">
+    >;
+
+    cliar::option<std::optional<bool>, "-", "--tcp"> tcp;
+    cliar::option<std::optional<bool>, "-", "--udp"> udp;
+    cliar::option<std::optional<std::string>, "-", "--host"> host;
+    cliar::option<std::optional<std::string>, "-", "--socket"> socket;
+    cliar::option<std::optional<std::string>, "-", "--user"> user;
+    cliar::option<std::optional<std::string>, "-", "--password"> password;
+};
+
+struct feature_flags
+{
+    cliar::option<bool, "-", "--fast-path", "enable the fast path"> fast_path;
+    cliar::option<std::optional<bool>, "enable experimental features"> experimental = false;
+    cliar::option<std::optional<bool>, "-", "simulate only"> dry_run;
+};
+
+struct feature_args
+{
+    cliar::option<std::optional<int>, "-", "--jobs"> jobs = 1;
+    cliar::flag_set<feature_flags> toggles;
+};
+
+struct log_args
+{
+    cliar::option<std::optional<int>, "-", "--log-level", "verbosity of the logs"> log_level = 2;
+};
+
 int main()
 {
     // fmt::print("{}\n", cliar::help<cli_args>(argv[0], "Additional help back there"));
@@ -42,19 +116,226 @@ int main()
             "--deduced-long-name", "12.34",
             "--short", "test",
             "--only-long", "-1.1",
-            "--set-both=100"
+            "--both=100"
         };
         auto res2 = cliar::parse<cli_args>(args2);
 
+        auto args3 = std::vector<char const *>{
+            "--verb",
+            "--this-deduces", "1",
+            "--deduced-l", "12.34",
+            "--sh", "test",
+            "--only-l=-1.1",
+        };
+        auto res3 = cliar::parse<cli_args>(args3, {.allow_abbreviations = true});
+
         bool all_ok = true;
-        reflect::for_each([&res1, &res2, &all_ok](auto I) {
-            auto const & value1 = reflect::get<I>(res1);
-            auto const & value2 = reflect::get<I>(res2);
-            if (value1 != value2) {
-                fmt::print("Error for member {}: {} != {}\n", reflect::member_name<I, cli_args>(), value1, value2);
+        auto expect_same = [&all_ok](std::string_view label, cli_args const & lhs, cli_args const & rhs) {
+            reflect::for_each([&all_ok, label, &lhs, &rhs](auto I) {
+                auto const & value1 = reflect::get<I>(lhs);
+                auto const & value2 = reflect::get<I>(rhs);
+                if (value1 != value2) {
+                    fmt::print("{} error for member {}: {} != {}\n", label, reflect::member_name<I, cli_args>(), value1, value2);
+                    all_ok = false;
+                }
+            }, lhs);
+        };
+        expect_same("Long name", res1, res2);
+        expect_same("Abbreviation", res1, res3);
+
+        auto restored = cliar::deserialize<cli_args>(cliar::serialize(res1));
+        expect_same("Snapshot", res1, restored);
+
+        auto const snapshot = cliar::serialize(res1);
+        auto corrupted = std::vector<std::vector<std::byte>>{
+            {snapshot.begin(), snapshot.end() - 1}, snapshot, snapshot, snapshot
+        };
+        corrupted[1][4] ^= std::byte{0xff};     // version
+        corrupted[2][8] ^= std::byte{0xff};     // schema hash
+        corrupted[3].push_back(std::byte{0});  // trailing bytes
+        for (auto const & bad : corrupted) {
+            try {
+                cliar::deserialize<cli_args>(bad);
+                fmt::print("Error: a corrupted snapshot of {} bytes was accepted\n", bad.size());
+                all_ok = false;
+            } catch (cliar::invalid_snapshot const &) {
+            }
+        }
+
+        auto args4 = args1;
+        args4.insert(args4.end(), {"--log-level", "5"});
+        auto [res4, log4] = cliar::parse<cli_args, log_args>(args4);
+        expect_same("Multi-parse", res1, res4);
+        if (log4.log_level != 5) {
+            fmt::print("Multi-parse error for member log_level: {} != 5\n", log4.log_level);
+            all_ok = false;
+        }
+
+        auto const line = std::string_view{R"(-v -t 1 -l '12.34' -d "test" --only-long=-1.1 -w false)"};
+        auto res5 = cliar::parse_line<cli_args>(line);
+        expect_same("Line parse", res1, res5);
+
+        auto const text = fmt::format("\r\n{0}\r\n  \t\r\n\n{0}\r\n{0}", line);
+        auto from_view = std::vector<cli_args>{};
+        std::ranges::copy(cliar::parse_lines<cli_args>(text), std::back_inserter(from_view));
+        auto from_stream = std::vector<cli_args>{};
+        auto stream = std::istringstream{text};
+        cliar::parse_lines<cli_args>(stream, [&from_stream](cli_args && cli) { from_stream.push_back(std::move(cli)); });
+        if (from_view.size() != 3 or from_stream.size() != 3) {
+            fmt::print("Error: parse_lines found {} and {} lines instead of 3\n", from_view.size(), from_stream.size());
+            all_ok = false;
+        }
+        for (auto const & cli : from_view) {
+            expect_same("Lazy parse_lines", res5, cli);
+        }
+        for (auto const & cli : from_stream) {
+            expect_same("Stream parse_lines", res5, cli);
+        }
+
+        auto const tokens = cliar::tokenized_line{R"(  --short "a b" x\ y --name='c'd "e\"f" )"};
+        auto const expected = std::vector<std::string_view>{"--short", "a b", "x y", "--name=cd", "e\"f"};
+        if (not std::ranges::equal(tokens.args(), expected)) {
+            fmt::print("Tokenizer error: {} != {}\n", tokens.args(), expected);
+            all_ok = false;
+        }
+        auto const inplace_tokens = cliar::inplace_tokenized_line<8>{R"(  --short "a b" x\ y --name='c'd "e\"f" )"};
+        if (not std::ranges::equal(inplace_tokens.args(), expected)) {
+            fmt::print("Inplace tokenizer error: {} != {}\n", inplace_tokens.args(), expected);
+            all_ok = false;
+        }
+
+        auto const allocations_before = allocations;
+        auto const hot_line = cliar::inplace_tokenized_line<8>{"-v -c 3 --name 'fast path' -r=0.25"};
+        auto const hot = cliar::parse<hot_args>(hot_line.args());
+        if (auto const allocated = allocations - allocations_before; allocated != 0) {
+            fmt::print("Error: {} heap allocations while parsing an inplace_tokenized_line\n", allocated);
+            all_ok = false;
+        }
+        if (hot.verbose != true or hot.count != 3 or hot.ratio != 0.25 or hot.name != std::string_view{"fast path"}) {
+            fmt::print("Error: wrong values parsed from an inplace_tokenized_line\n");
+            all_ok = false;
+        }
+
+        try {
+            auto too_long = args1;
+            too_long.insert(too_long.end(), {"--label", "longer than eight"});
+            cliar::parse<cli_args>(too_long);
+            fmt::print("Error: a value exceeding the inplace_string capacity was accepted\n");
+            all_ok = false;
+        } catch (cliar::wrong_option_type const &) {
+        }
+
+        auto shape1 = cliar::parse<shape_args>(std::vector<char const *>{"--tile", "256", "256", "4", "--range=10:2.5"});
+        auto shape2 = cliar::parse<shape_args>(std::vector<char const *>{"-t=256,256,4", "-r", "10", "2.5"});
+        if (shape1.tile != std::array{256, 256, 4} or shape1.tile != shape2.tile or shape1.range != shape2.range) {
+            fmt::print("Fixed arity error: {} / {} != {} / {}\n", shape1.tile, shape1.range, shape2.tile, shape2.range);
+            all_ok = false;
+        }
+        auto shape3 = cliar::parse<shape_args>(std::vector<char const *>{"--tile", "256,256,4", "--range", "10:2.5"});
+        if (shape3.tile != shape1.tile or shape3.range != shape1.range) {
+            fmt::print("Fixed arity error: {} / {} != {} / {}\n", shape3.tile, shape3.range, shape1.tile, shape1.range);
+            all_ok = false;
+        }
+
+        auto shape4 = cliar::parse<shape_args>(std::vector<char const *>{"--hosts", "http://a", "localhost:80", "-t", "1", "2", "3"});
+        if (shape4.hosts != std::array<std::string, 2>{"http://a", "localhost:80"} or shape4.tile != std::array{1, 2, 3}) {
+            fmt::print("Fixed arity error with delimiters in strings: {} / {}\n", shape4.hosts, shape4.tile);
+            all_ok = false;
+        }
+
+        auto const json = cliar::schema<cli_args>();
+        if (not json.contains(R"("long_name": "--label", "short_name": null, "type": "optional<string[8]>")")
+            or not json.contains(R"("default": "none")")) {
+            fmt::print("Schema error: {}\n", json);
+            all_ok = false;
+        }
+
+        auto const infinite_json = cliar::schema<cliar_test::schema_args>();
+        if (not infinite_json.contains(R"("member": "timeout", "long_name": "--timeout", "short_name": "-t", "type": "optional<float>", "required": false, "default": null)")) {
+            fmt::print("Schema error for a non-finite default: {}\n", infinite_json);
+            all_ok = false;
+        }
+
+        static_assert(cliar::flag_set<feature_flags>::bit_index<"dry_run">() == 2);
+        auto const features = cliar::parse<feature_args>(std::vector<char const *>{"--fast-path", "--jobs", "4", "-e"});
+        if (not features.toggles.get<"fast_path">() or features.toggles.get<"experimental">() != true
+            or features.toggles.get<"dry_run">().has_value() or features.jobs != 4) {
+            fmt::print("Error: packed flags were not parsed as boolean options\n");
+            all_ok = false;
+        }
+        if (cliar::deserialize<feature_args>(cliar::serialize(features)).toggles != features.toggles) {
+            fmt::print("Snapshot error for packed flags\n");
+            all_ok = false;
+        }
+        if (not cliar::help<feature_args>("test", "").contains("--dry-run")) {
+            fmt::print("Error: packed flags are missing from the help\n");
+            all_ok = false;
+        }
+        try {
+            cliar::parse<feature_args>(std::vector<char const *>{"--experimental"});
+            fmt::print("Error: a missing packed flag was accepted\n");
+            all_ok = false;
+        } catch (cliar::missing_required_option const &) {
+        }
+
+        auto expect_rejected = [&all_ok]<typename Exception>(std::type_identity<Exception>,
+                                                             std::vector<char const *> const & args) {
+            try {
+                cliar::parse<connection_args>(args);
+                fmt::print("Error: constraints not enforced for {}\n", args);
+                all_ok = false;
+            } catch (Exception const &) {
+            }
+        };
+        expect_rejected(std::type_identity<cliar::missing_required_option>{}, {"--host", "h"});
+        expect_rejected(std::type_identity<cliar::conflicting_options>{}, {"--tcp", "--udp", "--host", "h"});
+        expect_rejected(std::type_identity<cliar::missing_required_option>{}, {"--tcp"});
+        expect_rejected(std::type_identity<cliar::missing_required_option>{}, {"--tcp", "--host", "h", "--user", "u"});
+        auto const connection = cliar::parse<connection_args>(std::vector<char const *>{"--udp", "--socket", "s", "--password", "p"});
+        if (connection.udp != true or connection.socket != "s" or connection.tcp.has_value()) {
+            fmt::print("Error: valid options were rejected by the constraints\n");
+            all_ok = false;
+        }
+        auto const connection_help = cliar::help<connection_args>("test", "");
+        for (auto const line : {"CONSTRAINTS:", "exactly one of --tcp, --udp", "at least one of --host, --socket", "--user requires --password"}) {
+            if (not connection_help.contains(line)) {
+                fmt::print("Error: '{}' is missing from the help:\n{}\n", line, connection_help);
                 all_ok = false;
             }
-        }, res1);
+        }
+
+        try {
+            auto unknown = args1;
+            unknown.insert(unknown.end(), {"--only-longer", "1"});
+            cliar::parse<cli_args>(unknown, {.allow_abbreviations = true});
+            fmt::print("Error: an unknown option was accepted\n");
+            all_ok = false;
+        } catch (cliar::unknown_option const &) {
+        }
+
+        try {
+            auto ambiguous = args1;
+            ambiguous.push_back("--l=3");
+            cliar::parse<cli_args, log_args>(ambiguous, {.allow_abbreviations = true});
+            fmt::print("Error: an ambiguous abbreviation was accepted\n");
+            all_ok = false;
+        } catch (cliar::unknown_option const & exc) {
+            if (auto const what = std::string_view{exc.what()};
+                not what.contains("--label") or not what.contains("--log-level")) {
+                fmt::print("Error: ambiguous abbreviation without candidates: {}\n", what);
+                all_ok = false;
+            }
+        }
+
+        try {
+            auto conflicting = args1;
+            conflicting.insert(conflicting.end(), {"-o", "conflict"});
+            cliar::parse<cli_args>(conflicting);
+            fmt::print("Error: conflicting options were accepted\n");
+            all_ok = false;
+        } catch (cliar::conflicting_options const &) {
+        }
+
         if (all_ok) {
             fmt::print("All tests passed successfully!\n");
         }
@@ -0,0 +1,26 @@
+/**
+ * @author      : rbrugo (brugo.riccardo@gmail.com)
+ * @file        : schema_args
+ * @created     : Sunday Oct 18, 2026 16:02:41 CEST
+ * @description : Cli aggregate whose schema is generated at build time by `cliar_add_schema`
+ */
+
+#ifndef CLIAR_TEST_SCHEMA_ARGS_HPP
+#define CLIAR_TEST_SCHEMA_ARGS_HPP
+
+#include "cliar.hpp"
+
+namespace cliar_test
+{
+struct schema_args
+{
+    using constraints = std::tuple<cliar::exactly_one_of<"input", "from_stdin">>;
+
+    cliar::option<std::optional<std::string>, "input file"> input;
+    cliar::option<std::optional<bool>, "-", "--stdin", "read from the standard input"> from_stdin;
+    cliar::option<std::optional<double>, "give up after this many seconds"> timeout = std::numeric_limits<double>::infinity();
+    cliar::option<std::optional<std::array<int, 2>>, "-", "--window", "width and height"> window;
+};
+}  // namespace cliar_test
+
+#endif /* CLIAR_TEST_SCHEMA_ARGS_HPP */